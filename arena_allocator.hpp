@@ -0,0 +1,214 @@
+#ifndef ARENA_ALLOCATOR_HPP_INCLUDED
+#define ARENA_ALLOCATOR_HPP_INCLUDED
+
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+
+
+// monotonic (bump-pointer) memory resource
+// memory is taken from big chunks and is given back only all at once:
+// by reset() (keeps the last chunk for reuse) or by destructor
+// https://en.cppreference.com/w/cpp/memory/monotonic_buffer_resource
+class Arena
+{
+public:
+    typedef std::size_t size_type;
+
+    static const size_type defaultChunkSize = 64 * 1024;
+
+private:
+    struct Chunk
+    {
+        Chunk* next;
+        size_type size; // size of data after the header
+    };
+
+public:
+    explicit Arena(size_type chunkSize = defaultChunkSize):
+        _head(nullptr), _cur(nullptr), _end(nullptr), _chunkSize(chunkSize), _used(0)
+    {}
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    ~Arena()
+    {
+        release();
+    }
+
+    void* allocate(size_type bytes, size_type alignment = alignof(std::max_align_t))
+    {
+        char* p = _align(_cur, alignment);
+        if (_cur == nullptr || p + bytes > _end)
+        {
+            if (bytes + alignment > _chunkSize / 2)
+            {
+                // big block gets its own chunk, current chunk is still used
+                Chunk* chunk = _newChunk(bytes + alignment);
+                if (_head != nullptr)
+                {
+                    chunk->next = _head->next;
+                    _head->next = chunk;
+                }
+                else
+                {
+                    chunk->next = nullptr;
+                    _head = chunk;
+                    _cur = _end = _data(chunk) + chunk->size;
+                }
+                _used += bytes;
+                return _align(_data(chunk), alignment);
+            }
+            Chunk* chunk = _newChunk(_chunkSize);
+            chunk->next = _head;
+            _head = chunk;
+            _cur = _data(chunk);
+            _end = _cur + chunk->size;
+            p = _align(_cur, alignment);
+        }
+        _cur = p + bytes;
+        _used += bytes;
+        return p;
+    }
+
+    // all memory given by this arena becomes invalid
+    void reset() noexcept
+    {
+        if (_head == nullptr)
+            return;
+
+        _freeChunks(_head->next);
+        _head->next = nullptr;
+        _cur = _data(_head);
+        _end = _cur + _head->size;
+        _used = 0;
+    }
+
+    void release() noexcept
+    {
+        _freeChunks(_head);
+        _head = nullptr;
+        _cur = _end = nullptr;
+        _used = 0;
+    }
+
+    size_type bytes_used() const noexcept
+    {
+        return _used;
+    }
+
+private:
+    static char* _align(char* p, size_type alignment) noexcept
+    {
+        auto n = reinterpret_cast<std::uintptr_t>(p);
+        n = (n + alignment - 1) & ~(std::uintptr_t)(alignment - 1);
+        return reinterpret_cast<char*>(n);
+    }
+
+    static char* _data(Chunk* chunk) noexcept
+    {
+        return reinterpret_cast<char*>(chunk + 1);
+    }
+
+    static Chunk* _newChunk(size_type size)
+    {
+        Chunk* chunk = static_cast<Chunk*>(::operator new(sizeof(Chunk) + size));
+        chunk->next = nullptr;
+        chunk->size = size;
+        return chunk;
+    }
+
+    static void _freeChunks(Chunk* chunk) noexcept
+    {
+        for (; chunk != nullptr;)
+        {
+            Chunk* next = chunk->next;
+            ::operator delete(chunk);
+            chunk = next;
+        }
+    }
+
+private:
+    Chunk* _head;
+    char* _cur;
+    char* _end;
+    size_type _chunkSize;
+    size_type _used;
+};
+
+// allocator for DynArr, ForwardList, AVLTree etc.
+// deallocate does nothing, memory is given back by the arena itself
+// default constructed allocator (without arena) uses global operator new
+// https://en.cppreference.com/w/cpp/named_req/Allocator
+template < typename T >
+class ArenaAllocator
+{
+public:
+    typedef T value_type;
+    typedef value_type* pointer;
+    typedef const value_type* const_pointer;
+    typedef value_type& reference;
+    typedef const value_type& const_reference;
+    typedef std::size_t size_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef std::true_type propagate_on_container_copy_assignment;
+    typedef std::true_type propagate_on_container_move_assignment;
+    typedef std::true_type propagate_on_container_swap;
+
+    template < typename U >
+    struct rebind
+    {
+        typedef ArenaAllocator<U> other;
+    };
+
+template < typename U >
+    friend class ArenaAllocator;
+
+public:
+    ArenaAllocator() noexcept: _arena(nullptr)
+    {}
+    ArenaAllocator(Arena& arena) noexcept: _arena(&arena)
+    {}
+    ArenaAllocator(const ArenaAllocator& other) = default;
+    template < typename U >
+    ArenaAllocator(const ArenaAllocator<U>& other) noexcept: _arena(other._arena)
+    {}
+
+    pointer allocate(size_type n)
+    {
+        if (_arena == nullptr)
+            return static_cast<pointer>(::operator new(n * sizeof(value_type)));
+
+        return static_cast<pointer>(_arena->allocate(n * sizeof(value_type), alignof(value_type)));
+    }
+
+    void deallocate(pointer p, size_type) noexcept
+    {
+        if (_arena == nullptr)
+            ::operator delete(p);
+    }
+
+    Arena* arena() const noexcept
+    {
+        return _arena;
+    }
+
+private:
+    Arena* _arena;
+};
+
+template < typename T, typename U >
+bool operator==(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) noexcept
+{
+    return a.arena() == b.arena();
+}
+template < typename T, typename U >
+bool operator!=(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) noexcept
+{
+    return !(a == b);
+}
+
+
+#endif // ARENA_ALLOCATOR_HPP_INCLUDED
@@ -7,60 +7,95 @@
 #include <iterator>
 #include <utility>
 #include <stdexcept>
+#include <future>
+#include <thread>
+#include <system_error>
+#include <type_traits>
 
 #include <iostream>
 
 #include "stack.hpp"
+#include "dynamic_array.hpp"
+#include "tim_sort.hpp"
 
 //! left < root < right
 
-// node structure
-template < typename Key >
-struct TreeNode
+// subtree size of node, it is kept only for order statistics
+template < bool Counted >
+struct TreeNodeCount
+{
+    explicit TreeNodeCount(size_t count): count(count)
+    {}
+
+    size_t count; // number of nodes in subtree
+};
+template <>
+struct TreeNodeCount<false>
+{
+    explicit TreeNodeCount(size_t)
+    {}
+};
+
+// node structure, without Counted it has no count (empty base takes no memory)
+template < typename Key, bool Counted = true >
+struct TreeNode: public TreeNodeCount<Counted>
 {
     typedef Key value_type;
-    typedef TreeNode<value_type> node_type;
+    typedef TreeNode<value_type, Counted> node_type;
     typedef node_type* node_pointer;
 
-    TreeNode(const value_type& value, node_pointer left, node_pointer right, size_t height):
-        value(value), left(left), right(right), height(height)
+    TreeNode(const value_type& value, node_pointer left, node_pointer right, node_pointer parent, 
+            size_t height, size_t count):
+        TreeNodeCount<Counted>(count), value(value), left(left), right(right), parent(parent), 
+        height(height)
     {}
-    TreeNode(value_type&& value, node_pointer left, node_pointer right, size_t height):
-        value(std::move(value)), left(left), right(right), height(height)
+    TreeNode(value_type&& value, node_pointer left, node_pointer right, node_pointer parent, 
+            size_t height, size_t count):
+        TreeNodeCount<Counted>(count), value(std::move(value)), left(left), right(right), 
+        parent(parent), height(height)
+    {}
+    // detached node, value is constructed from args
+    template < typename... Args >
+    TreeNode(std::in_place_t, Args&&... args):
+        TreeNodeCount<Counted>(1), value(std::forward<Args>(args)...), left(nullptr), 
+        right(nullptr), parent(nullptr), height(1)
     {}
     TreeNode(const TreeNode& other) = default;
     TreeNode(TreeNode&& other) = default;
 
-    operator TreeNode<const value_type>() const noexcept
+    operator TreeNode<const value_type, Counted>() const noexcept
     {
-        return TreeNode<const value_type>((const value_type*)value, left, right, height);
+        return TreeNode<const value_type, Counted>((const value_type*)value, left, right, parent, 
+            height, this->count);
     }
-    operator TreeNode<std::remove_const<value_type>>() const noexcept
+    operator TreeNode<std::remove_const<value_type>, Counted>() const noexcept
     {
-        return TreeNode<std::remove_const<value_type>>((std::remove_const<value_type>*)value, left, right, height);
+        return TreeNode<std::remove_const<value_type>, Counted>(
+            (std::remove_const<value_type>*)value, left, right, parent, height, this->count);
     }
 
     value_type value;
     node_pointer left;
     node_pointer right;
+    node_pointer parent; // nullptr for root
     size_t height;
 };
 
 // forward iterators
 
-template < typename Key >
+template < typename Key, bool Counted = true >
 class TreeForwardIterator;
-template < typename Key >
+template < typename Key, bool Counted = true >
 class RootLeftRightIterator;
-template < typename Key >
+template < typename Key, bool Counted = true >
 class LeftRootRightIterator;
-template < typename Key >
+template < typename Key, bool Counted = true >
 class LeftRightRootIterator;
-template < typename Key >
+template < typename Key, bool Counted = true >
 class WidthIterator;
 
 // https://en.cppreference.com/w/cpp/named_req/ForwardIterator
-template < typename Key >
+template < typename Key, bool Counted >
 class TreeForwardIterator
 {
 public:
@@ -73,13 +108,13 @@ public:
     typedef const value_type& const_reference;
 
 protected:
-    typedef typename TreeNode<Key>::node_type node_type;
-    typedef typename TreeNode<Key>::node_pointer node_pointer;
+    typedef typename TreeNode<Key, Counted>::node_type node_type;
+    typedef typename TreeNode<Key, Counted>::node_pointer node_pointer;
 
-template < typename Key1, typename Compare, typename Allocator >
+template < typename Key1, typename Compare, typename Allocator, bool OrderStatistics >
     friend class AVLTree;
 
-template < typename Key1 >
+template < typename Key1, bool Counted1 >
     friend class TreeForwardIterator;
 
 protected:
@@ -96,10 +131,10 @@ protected:
     TreeForwardIterator(node_pointer node): _node(node)
     {}
 
-    operator TreeForwardIterator<std::remove_const<value_type>>() const noexcept
+    operator TreeForwardIterator<std::remove_const<value_type>, Counted>() const noexcept
     {
-        auto nodeP = (TreeNode<std::remove_const<value_type>>*)_node;
-        return TreeForwardIterator<std::remove_const<value_type>>(nodeP);
+        auto nodeP = (TreeNode<std::remove_const<value_type>, Counted>*)_node;
+        return TreeForwardIterator<std::remove_const<value_type>, Counted>(nodeP);
     }
 
 public:
@@ -137,57 +172,55 @@ public:
         return !(*this == other);
     }
 
-    operator TreeForwardIterator<const value_type>() const noexcept
+    operator TreeForwardIterator<const value_type, Counted>() const noexcept
     {
-        auto nodeP = (TreeNode<const value_type>*)_node;
-        return TreeForwardIterator<const value_type>(nodeP);
+        auto nodeP = (TreeNode<const value_type, Counted>*)_node;
+        return TreeForwardIterator<const value_type, Counted>(nodeP);
     }
 
 protected:
     node_pointer _node;
 };
 
-template < typename Key >
-class RootLeftRightIterator: public TreeForwardIterator<Key>
+template < typename Key, bool Counted >
+class RootLeftRightIterator: public TreeForwardIterator<Key, Counted>
 {
 public:
-    typedef typename TreeForwardIterator<Key>::iterator_category iterator_category;
-    typedef typename TreeForwardIterator<Key>::value_type value_type;
-    typedef typename TreeForwardIterator<Key>::difference_type difference_type;
-    typedef typename TreeForwardIterator<Key>::pointer pointer;
-    typedef typename TreeForwardIterator<Key>::const_pointer const_pointer;
-    typedef typename TreeForwardIterator<Key>::reference reference;
-    typedef typename TreeForwardIterator<Key>::const_reference const_reference;
+    typedef typename TreeForwardIterator<Key, Counted>::iterator_category iterator_category;
+    typedef typename TreeForwardIterator<Key, Counted>::value_type value_type;
+    typedef typename TreeForwardIterator<Key, Counted>::difference_type difference_type;
+    typedef typename TreeForwardIterator<Key, Counted>::pointer pointer;
+    typedef typename TreeForwardIterator<Key, Counted>::const_pointer const_pointer;
+    typedef typename TreeForwardIterator<Key, Counted>::reference reference;
+    typedef typename TreeForwardIterator<Key, Counted>::const_reference const_reference;
 
 private:
-    typedef typename TreeForwardIterator<Key>::node_type node_type;
-    typedef typename TreeForwardIterator<Key>::node_pointer node_pointer;
+    typedef typename TreeForwardIterator<Key, Counted>::node_type node_type;
+    typedef typename TreeForwardIterator<Key, Counted>::node_pointer node_pointer;
 
-template < typename Key1, typename Compare, typename Allocator >
+template < typename Key1, typename Compare, typename Allocator, bool OrderStatistics >
     friend class AVLTree;
 
-template < typename Key1 >
+template < typename Key1, bool Counted1 >
     friend class RootLeftRightIterator;
 
 private:
-    RootLeftRightIterator(node_pointer node): TreeForwardIterator<Key>(node)
-    {
-        _path.push(node);
-    }
+    RootLeftRightIterator(node_pointer node): TreeForwardIterator<Key, Counted>(node)
+    {}
 
-    operator RootLeftRightIterator<std::remove_const<value_type>>() const noexcept
+    operator RootLeftRightIterator<std::remove_const<value_type>, Counted>() const noexcept
     {
-        auto nodeP = (TreeNode<std::remove_const<value_type>>*)TreeForwardIterator<Key>::_node;
-        return RootLeftRightIterator<std::remove_const<value_type>>(nodeP);
+        auto nodeP = (TreeNode<std::remove_const<value_type>, Counted>*)
+            TreeForwardIterator<Key, Counted>::_node;
+        return RootLeftRightIterator<std::remove_const<value_type>, Counted>(nodeP);
     }
 
 public:
     RootLeftRightIterator()
     {}
-    RootLeftRightIterator(const TreeForwardIterator<Key>& x): TreeForwardIterator<Key>(x)
-    {
-        _path.push(this->_node);
-    }
+    RootLeftRightIterator(const TreeForwardIterator<Key, Counted>& x):
+        TreeForwardIterator<Key, Counted>(x)
+    {}
     RootLeftRightIterator(const RootLeftRightIterator& other) = default;
 
     ~RootLeftRightIterator()
@@ -195,118 +228,95 @@ public:
 
     RootLeftRightIterator& operator++()
     {
-        if (this->_node != nullptr)
-        {
-            _path.pop();
-            if (this->_node->right != nullptr)
-                _path.push(this->_node->right);
-            if (this->_node->left != nullptr)
-                _path.push(this->_node->left);
-        }
-        if (!_path.empty())
-            this->_node = _path.top();
-        else
-            this->_node = nullptr;
-
+        _goToNext();
         return *this;
     }
-    RootLeftRightIterator& operator++(int)
+    RootLeftRightIterator operator++(int)
     {
-        RootLeftRightIterator<value_type>oldIter(*this);
-        if (this->_node != nullptr)
-        {
-            _path.pop();
-            if (this->_node->right != nullptr)
-                _path.push(this->_node->right);
-            if (this->_node->left != nullptr)
-                _path.push(this->_node->left);
-        }
-        if (!_path.empty())
-            this->_node = _path.top();
-        else
-            this->_node = nullptr;
-
+        RootLeftRightIterator<value_type, Counted>oldIter(*this);
+        _goToNext();
         return oldIter;
     }
 
-    operator RootLeftRightIterator<const value_type>() const noexcept
+    operator RootLeftRightIterator<const value_type, Counted>() const noexcept
     {
-        auto nodeP = (TreeNode<const value_type>*)this->_node;
-        return RootLeftRightIterator<const value_type>(nodeP);
+        auto nodeP = (TreeNode<const value_type, Counted>*)this->_node;
+        return RootLeftRightIterator<const value_type, Counted>(nodeP);
     }
 
 private:
-    Stack<node_pointer> _path;
+    void _goToNext()
+    {
+        auto n = this->_node;
+        if (n == nullptr)
+            return;
+
+        if (n->left != nullptr)
+            this->_node = n->left;
+        else if (n->right != nullptr)
+            this->_node = n->right;
+        else
+        {
+            // going up until there is a right subtree which was not visited
+            auto p = n->parent;
+            for (; p != nullptr && (n == p->right || p->right == nullptr); p = p->parent)
+                n = p;
+
+            this->_node = p != nullptr ? p->right : nullptr;
+        }
+    }
 };
 
-template < typename Key >
-class LeftRootRightIterator: public TreeForwardIterator<Key>
+template < typename Key, bool Counted >
+class LeftRootRightIterator: public TreeForwardIterator<Key, Counted>
 {
 public:
-    typedef typename TreeForwardIterator<Key>::iterator_category iterator_category;
-    typedef typename TreeForwardIterator<Key>::value_type value_type;
-    typedef typename TreeForwardIterator<Key>::difference_type difference_type;
-    typedef typename TreeForwardIterator<Key>::pointer pointer;
-    typedef typename TreeForwardIterator<Key>::const_pointer const_pointer;
-    typedef typename TreeForwardIterator<Key>::reference reference;
-    typedef typename TreeForwardIterator<Key>::const_reference const_reference;
+    typedef typename TreeForwardIterator<Key, Counted>::iterator_category iterator_category;
+    typedef typename TreeForwardIterator<Key, Counted>::value_type value_type;
+    typedef typename TreeForwardIterator<Key, Counted>::difference_type difference_type;
+    typedef typename TreeForwardIterator<Key, Counted>::pointer pointer;
+    typedef typename TreeForwardIterator<Key, Counted>::const_pointer const_pointer;
+    typedef typename TreeForwardIterator<Key, Counted>::reference reference;
+    typedef typename TreeForwardIterator<Key, Counted>::const_reference const_reference;
 
 private:
-    typedef typename TreeForwardIterator<Key>::node_type node_type;
-    typedef typename TreeForwardIterator<Key>::node_pointer node_pointer;
+    typedef typename TreeForwardIterator<Key, Counted>::node_type node_type;
+    typedef typename TreeForwardIterator<Key, Counted>::node_pointer node_pointer;
 
-template < typename Key1, typename Compare, typename Allocator >
+template < typename Key1, typename Compare, typename Allocator, bool OrderStatistics >
     friend class AVLTree;
 
-template < typename Key1 >
+template < typename Key1, bool Counted1 >
     friend class LeftRootRightIterator;
 
 private:
-    LeftRootRightIterator(node_pointer node): TreeForwardIterator<Key>(node)
+    LeftRootRightIterator(node_pointer node): TreeForwardIterator<Key, Counted>(node)
     {
-        // moving left if it possible
-        for (auto n = node; n != nullptr; n = n->left)
-            _path.push(n);
-        
-        if (this->_node != nullptr)
-        {
-            this->_node = _path.top();
-            _path.pop();
-            _curr = this->_node->right;
-        }
-        else
-        {
-            this->_node = nullptr;
-            _curr = nullptr;
-        }
+        _goToFirst();
     }
 
-    operator LeftRootRightIterator<std::remove_const<value_type>>() const noexcept
+    operator LeftRootRightIterator<std::remove_const<value_type>, Counted>() const noexcept
     {
-        auto nodeP = (TreeNode<std::remove_const<value_type>>*)TreeForwardIterator<Key>::_node;
-        return LeftRootRightIterator<std::remove_const<value_type>>(nodeP);
+        auto nodeP = (TreeNode<std::remove_const<value_type>, Counted>*)
+            TreeForwardIterator<Key, Counted>::_node;
+        return LeftRootRightIterator<std::remove_const<value_type>, Counted>(nodeP);
+    }
+
+    // iterator which points exactly to node, not to the first node of its subtree
+    static LeftRootRightIterator _at(node_pointer node) noexcept
+    {
+        LeftRootRightIterator iter;
+        iter._node = node;
+        return iter;
     }
 
 public:
     LeftRootRightIterator()
     {}
-    LeftRootRightIterator(const TreeForwardIterator<Key>& x): TreeForwardIterator<Key>(x)
+    LeftRootRightIterator(const TreeForwardIterator<Key, Counted>& x):
+        TreeForwardIterator<Key, Counted>(x)
     {
-        // moving left if it possible
-        for (auto n = this->_node; n != nullptr; n = n->left)
-            _path.push(n);
-        
-        if (this->_node != nullptr)
-        {
-            this->_node = _path.top();
-            _path.pop();
-            _curr = this->_node->right;
-        }
-        else
-        {
-            this->_node = nullptr;
-            _curr = nullptr;
-        }
+        _goToFirst();
     }
     LeftRootRightIterator(const LeftRootRightIterator& other) = default;
 
@@ -315,128 +325,97 @@ public:
 
     LeftRootRightIterator& operator++()
     {
-        while (!_path.empty() || _curr != nullptr)
-        {
-            if (_curr != nullptr)
-            {
-                _path.push(_curr);
-                _curr = _curr->left;
-            }
-            else
-            {
-                _curr = _path.top();
-                _path.pop();
-                this->_node = _curr;
-                _curr = _curr->right;
-                return *this;
-            }
-        }
-        this->_node = nullptr;
+        _goToNext();
         return *this;
     }
-    LeftRootRightIterator& operator++(int)
+    LeftRootRightIterator operator++(int)
     {
-        LeftRootRightIterator<value_type>oldIter(*this);
-        while (!_path.empty() || _curr != nullptr)
-        {
-            if (_curr != nullptr)
-            {
-                _path.push(_curr);
-                _curr = _curr->left;
-            }
-            else
-            {
-                _curr = _path.top();
-                _path.pop();
-                this->_node = _curr;
-                _curr = _curr->right;
-                return oldIter;
-            }
-        }
-        this->_node = nullptr;
+        LeftRootRightIterator<value_type, Counted>oldIter(*this);
+        _goToNext();
+        return oldIter;
     }
 
-    operator LeftRootRightIterator<const value_type>() const noexcept
+    operator LeftRootRightIterator<const value_type, Counted>() const noexcept
     {
-        auto nodeP = (TreeNode<const value_type>*)this->_node;
-        return LeftRootRightIterator<const value_type>(nodeP);
+        auto nodeP = (TreeNode<const value_type, Counted>*)this->_node;
+        return LeftRootRightIterator<const value_type, Counted>(nodeP);
     }
 
 private:
-    Stack<node_pointer> _path;
-    node_pointer _curr;
+    // moving left if it possible
+    void _goToFirst()
+    {
+        if (this->_node == nullptr)
+            return;
+
+        for (; this->_node->left != nullptr;)
+            this->_node = this->_node->left;
+    }
+
+    void _goToNext()
+    {
+        auto n = this->_node;
+        if (n == nullptr)
+            return;
+
+        if (n->right != nullptr)
+        {
+            // the most left node of right subtree
+            this->_node = n->right;
+            _goToFirst();
+            return;
+        }
+        // going up until we come from left subtree
+        auto p = n->parent;
+        for (; p != nullptr && n == p->right; p = p->parent)
+            n = p;
+
+        this->_node = p;
+    }
 };
 
-template < typename Key >
-class LeftRightRootIterator: public TreeForwardIterator<Key>
+template < typename Key, bool Counted >
+class LeftRightRootIterator: public TreeForwardIterator<Key, Counted>
 {
 public:
-    typedef typename TreeForwardIterator<Key>::iterator_category iterator_category;
-    typedef typename TreeForwardIterator<Key>::value_type value_type;
-    typedef typename TreeForwardIterator<Key>::difference_type difference_type;
-    typedef typename TreeForwardIterator<Key>::pointer pointer;
-    typedef typename TreeForwardIterator<Key>::const_pointer const_pointer;
-    typedef typename TreeForwardIterator<Key>::reference reference;
-    typedef typename TreeForwardIterator<Key>::const_reference const_reference;
+    typedef typename TreeForwardIterator<Key, Counted>::iterator_category iterator_category;
+    typedef typename TreeForwardIterator<Key, Counted>::value_type value_type;
+    typedef typename TreeForwardIterator<Key, Counted>::difference_type difference_type;
+    typedef typename TreeForwardIterator<Key, Counted>::pointer pointer;
+    typedef typename TreeForwardIterator<Key, Counted>::const_pointer const_pointer;
+    typedef typename TreeForwardIterator<Key, Counted>::reference reference;
+    typedef typename TreeForwardIterator<Key, Counted>::const_reference const_reference;
 
 private:
-    typedef typename TreeForwardIterator<Key>::node_type node_type;
-    typedef typename TreeForwardIterator<Key>::node_pointer node_pointer;
+    typedef typename TreeForwardIterator<Key, Counted>::node_type node_type;
+    typedef typename TreeForwardIterator<Key, Counted>::node_pointer node_pointer;
 
-template < typename Key1, typename Compare, typename Allocator >
+template < typename Key1, typename Compare, typename Allocator, bool OrderStatistics >
     friend class AVLTree;
 
-template < typename Key1 >
+template < typename Key1, bool Counted1 >
     friend class LeftRightRootIterator;
 
 private:
-    LeftRightRootIterator(node_pointer node): TreeForwardIterator<Key>(node)
+    LeftRightRootIterator(node_pointer node): TreeForwardIterator<Key, Counted>(node)
     {
-        if (node == nullptr)
-            return;
-    
-        _path.push(node);
-        for(; !_path.empty();)
-        {
-            _curr = _path.top();
-            _path.pop();
-            _out.push(_curr);
-            if (_curr->left != nullptr)
-                _path.push(_curr->left);
-            if (_curr->right != nullptr)
-                _path.push(_curr->right);
-        }
-        this->_node = _out.top();
-        _out.pop();
+        _goToFirst();
     }
 
-    operator LeftRightRootIterator<std::remove_const<value_type>>() const noexcept
+    operator LeftRightRootIterator<std::remove_const<value_type>, Counted>() const noexcept
     {
-        auto nodeP = (TreeNode<std::remove_const<value_type>>*)TreeForwardIterator<Key>::_node;
-        return LeftRightRootIterator<std::remove_const<value_type>>(nodeP);
+        auto nodeP = (TreeNode<std::remove_const<value_type>, Counted>*)
+            TreeForwardIterator<Key, Counted>::_node;
+        return LeftRightRootIterator<std::remove_const<value_type>, Counted>(nodeP);
     }
 
 public:
     LeftRightRootIterator()
     {}
-    LeftRightRootIterator(const TreeForwardIterator<Key>& x): TreeForwardIterator<Key>(x)
+    LeftRightRootIterator(const TreeForwardIterator<Key, Counted>& x):
+        TreeForwardIterator<Key, Counted>(x)
     {
-        if (this->_node == nullptr)
-            return;
-    
-        _path.push(this->_node);
-        for(; !_path.empty();)
-        {
-            _curr = _path.top();
-            _path.pop();
-            _out.push(_curr);
-            if (_curr->left != nullptr)
-                _path.push(_curr->left);
-            if (_curr->right != nullptr)
-                _path.push(_curr->right);
-        }
-        this->_node = _out.top();
-        _out.pop();
+        _goToFirst();
     }
     LeftRightRootIterator(const LeftRightRootIterator& other) = default;
 
@@ -445,66 +424,78 @@ public:
 
     LeftRightRootIterator& operator++()
     {
-        if(!_out.empty())
-        {
-            this->_node = _out.top();
-            _out.pop();
-        }
-        else
-            this->_node = nullptr;
-
+        _goToNext();
         return *this;
     }
-    LeftRightRootIterator& operator++(int)
+    LeftRightRootIterator operator++(int)
     {
-        LeftRightRootIterator<value_type>oldIter(*this);
-        if(!_out.empty())
-        {
-            this->_node = _out.top();
-            _out.pop();
-        }
-        else
-            this->_node = nullptr;
-
+        LeftRightRootIterator<value_type, Counted>oldIter(*this);
+        _goToNext();
         return oldIter;
     }
 
-    operator LeftRightRootIterator<const value_type>() const noexcept
+    operator LeftRightRootIterator<const value_type, Counted>() const noexcept
     {
-        auto nodeP = (TreeNode<const value_type>*)this->_node;
-        return LeftRightRootIterator<const value_type>(nodeP);
+        auto nodeP = (TreeNode<const value_type, Counted>*)this->_node;
+        return LeftRightRootIterator<const value_type, Counted>(nodeP);
     }
 
 private:
-    Stack<node_pointer> _path;
-    Stack<node_pointer> _out; // storing LRN traversal
-    node_pointer _curr;
+    // going down to the first node of subtree in LRN order
+    void _goToFirst()
+    {
+        auto n = this->_node;
+        if (n == nullptr)
+            return;
+
+        for (; n->left != nullptr || n->right != nullptr;)
+            n = n->left != nullptr ? n->left : n->right;
+
+        this->_node = n;
+    }
+
+    void _goToNext()
+    {
+        auto n = this->_node;
+        if (n == nullptr)
+            return;
+
+        auto p = n->parent;
+        if (p != nullptr && n == p->left && p->right != nullptr)
+        {
+            this->_node = p->right;
+            _goToFirst();
+        }
+        else
+            // root was the last node if p == nullptr
+            this->_node = p;
+    }
 };
 
-template < typename Key >
-class WidthIterator: public TreeForwardIterator<Key>
+template < typename Key, bool Counted >
+class WidthIterator: public TreeForwardIterator<Key, Counted>
 {
 public:
-    typedef typename TreeForwardIterator<Key>::iterator_category iterator_category;
-    typedef typename TreeForwardIterator<Key>::value_type value_type;
-    typedef typename TreeForwardIterator<Key>::difference_type difference_type;
-    typedef typename TreeForwardIterator<Key>::pointer pointer;
-    typedef typename TreeForwardIterator<Key>::const_pointer const_pointer;
-    typedef typename TreeForwardIterator<Key>::reference reference;
-    typedef typename TreeForwardIterator<Key>::const_reference const_reference;
+    typedef typename TreeForwardIterator<Key, Counted>::iterator_category iterator_category;
+    typedef typename TreeForwardIterator<Key, Counted>::value_type value_type;
+    typedef typename TreeForwardIterator<Key, Counted>::difference_type difference_type;
+    typedef typename TreeForwardIterator<Key, Counted>::pointer pointer;
+    typedef typename TreeForwardIterator<Key, Counted>::const_pointer const_pointer;
+    typedef typename TreeForwardIterator<Key, Counted>::reference reference;
+    typedef typename TreeForwardIterator<Key, Counted>::const_reference const_reference;
 
 private:
-    typedef typename TreeForwardIterator<Key>::node_type node_type;
-    typedef typename TreeForwardIterator<Key>::node_pointer node_pointer;
+    typedef typename TreeForwardIterator<Key, Counted>::node_type node_type;
+    typedef typename TreeForwardIterator<Key, Counted>::node_pointer node_pointer;
 
-template < typename Key1, typename Compare, typename Allocator >
+template < typename Key1, typename Compare, typename Allocator, bool OrderStatistics >
     friend class AVLTree;
 
-template < typename Key1 >
+template < typename Key1, bool Counted1 >
     friend class WidthIterator;
 
 private:
-    WidthIterator(node_pointer node): TreeForwardIterator<Key>(node)
+    WidthIterator(node_pointer node): TreeForwardIterator<Key, Counted>(node)
     {
         if (this->_node == nullptr)
             return;
@@ -515,16 +506,18 @@ private:
             _first.push(this->_node->right);
     }
 
-    operator WidthIterator<std::remove_const<value_type>>() const noexcept
+    operator WidthIterator<std::remove_const<value_type>, Counted>() const noexcept
     {
-        auto nodeP = (TreeNode<std::remove_const<value_type>>*)TreeForwardIterator<Key>::_node;
-        return WidthIterator<std::remove_const<value_type>>(nodeP);
+        auto nodeP = (TreeNode<std::remove_const<value_type>, Counted>*)
+            TreeForwardIterator<Key, Counted>::_node;
+        return WidthIterator<std::remove_const<value_type>, Counted>(nodeP);
     }
 
 public:
     WidthIterator()
     {}
-    WidthIterator(const TreeForwardIterator<Key>& x): TreeForwardIterator<Key>(x)
+    WidthIterator(const TreeForwardIterator<Key, Counted>& x):
+        TreeForwardIterator<Key, Counted>(x)
     {
         if (this->_node == nullptr)
             return;
@@ -572,9 +565,9 @@ public:
         }
         return *this;
     }
-    WidthIterator& operator++(int)
+    WidthIterator operator++(int)
     {
-        WidthIterator<value_type>oldIter(*this);
+        WidthIterator<value_type, Counted>oldIter(*this);
         if (_first.empty() && _second.empty())
             this->_node = nullptr;
         else
@@ -607,10 +600,10 @@ public:
         return oldIter;
     }
 
-    operator WidthIterator<const value_type>() const noexcept
+    operator WidthIterator<const value_type, Counted>() const noexcept
     {
-        auto nodeP = (TreeNode<const value_type>*)this->_node;
-        return WidthIterator<const value_type>(nodeP);
+        auto nodeP = (TreeNode<const value_type, Counted>*)this->_node;
+        return WidthIterator<const value_type, Counted>(nodeP);
     }
 
 private:
@@ -619,7 +612,12 @@ private:
     bool _isNowFirst = true;
 };
 
-template < typename Key, typename Compare = std::less<Key>, typename Allocator = std::allocator<Key> >
+// OrderStatistics: subtree sizes are kept in nodes, they are needed for
+// rank, select, count_range, join, split and set operations; without them
+// nodes have no count field and insert and erase do not update sizes on the path
+// (these functions do not compile then)
+template < typename Key, typename Compare = std::less<Key>, typename Allocator = std::allocator<Key>,
+    bool OrderStatistics = true >
 class AVLTree
 {
 public:
@@ -635,63 +633,95 @@ public:
     typedef typename std::allocator_traits<Allocator>::pointer pointer;
     typedef typename std::allocator_traits<Allocator>::const_pointer const_pointer;
 
-    typedef TreeForwardIterator<Key> iterator;
-    typedef TreeForwardIterator<const Key> const_iterator;
+    typedef TreeForwardIterator<Key, OrderStatistics> iterator;
+    typedef TreeForwardIterator<const Key, OrderStatistics> const_iterator;
 
-    typedef RootLeftRightIterator<Key> root_left_right_iterator;
-    typedef RootLeftRightIterator<const Key> const_root_left_right_iterator;
+    typedef RootLeftRightIterator<Key, OrderStatistics> root_left_right_iterator;
+    typedef RootLeftRightIterator<const Key, OrderStatistics> const_root_left_right_iterator;
 
-    typedef LeftRootRightIterator<Key> left_root_right_iterator;
-    typedef LeftRootRightIterator<const Key> const_left_root_right_iterator;
+    typedef LeftRootRightIterator<Key, OrderStatistics> left_root_right_iterator;
+    typedef LeftRootRightIterator<const Key, OrderStatistics> const_left_root_right_iterator;
 
-    typedef LeftRightRootIterator<Key> left_right_root_iterator;
-    typedef LeftRightRootIterator<const Key> const_left_right_root_iterator;
+    typedef LeftRightRootIterator<Key, OrderStatistics> left_right_root_iterator;
+    typedef LeftRightRootIterator<const Key, OrderStatistics> const_left_right_root_iterator;
 
-    typedef WidthIterator<Key> width_iterator;
-    typedef WidthIterator<const Key> const_width_iterator;
+    typedef WidthIterator<Key, OrderStatistics> width_iterator;
+    typedef WidthIterator<const Key, OrderStatistics> const_width_iterator;
 
 private:
     template < typename Alloc >
     using traits = std::allocator_traits<Alloc>;
 
-    typedef typename Allocator::template rebind<TreeNode<Key>>::other NodeAllocator;
-    typedef TreeNode<value_type> node_type;
+    typedef typename Allocator::template rebind<TreeNode<Key, OrderStatistics>>::other NodeAllocator;
+    typedef TreeNode<value_type, OrderStatistics> node_type;
     typedef node_type& node_reference;
     typedef const value_type& const_node_reference;
     typedef typename traits<NodeAllocator>::pointer node_pointer;
     typedef typename traits<NodeAllocator>::const_pointer const_node_pointer;
+    typedef typename Allocator::template rebind<node_pointer>::other NodePointerAllocator;
+    struct BatchDeleter
+    {
+        NodeAllocator alloc;
+        size_type count;
+
+        void operator()(node_pointer nodeP) noexcept
+        {
+            traits<NodeAllocator>::deallocate(alloc, nodeP, count);
+        }
+    };
+    // nodes allocated by one call, trees made by split share it
+    typedef std::pair<std::shared_ptr<node_type>, size_type> batch_type;
+    typedef typename Allocator::template rebind<batch_type>::other BatchAllocator;
+
+    enum class SetOperation { Union, Intersection, Difference };
+    // set operations on smaller trees are not split between threads
+    static const size_type parallelGrain = 1 << 14;
 
 public:
     AVLTree(): _root(nullptr), _size(0)
     {}
     explicit AVLTree(const Compare& comp, const Allocator& alloc = Allocator()):
-        _root(nullptr), _size(0), _cmp(comp), _alloc(alloc)
+        _root(nullptr), _size(0), _cmp(comp), _alloc(alloc), _nodeAlloc(alloc), _batches(alloc)
     {}
     explicit AVLTree(const Allocator& alloc):
-        _root(nullptr), _size(0), _alloc(alloc)
+        _root(nullptr), _size(0), _alloc(alloc), _nodeAlloc(alloc), _batches(alloc)
     {}
-    AVLTree(const AVLTree& other);
-    AVLTree(const AVLTree& other, const Allocator& alloc);
+    template < typename InputIt >
+    AVLTree(InputIt first, InputIt last,
+        const Compare& comp = Compare(),
+        const Allocator& alloc = Allocator()):
+        AVLTree(comp, alloc)
+    {
+        insert(first, last);
+    }
+    AVLTree(const AVLTree& other): AVLTree(other._cmp, other._alloc)
+    {
+        // keys of other are already sorted and unique
+        _mergeSorted(left_root_right_iterator(other._root), left_root_right_iterator(nullptr));
+    }
+    AVLTree(const AVLTree& other, const Allocator& alloc): AVLTree(other._cmp, alloc)
+    {
+        _mergeSorted(left_root_right_iterator(other._root), left_root_right_iterator(nullptr));
+    }
     AVLTree(AVLTree&& other):
-        _root(other->_root), _size(other->_size), _cmp(other->_cmp), _alloc(other->_alloc)
+        _root(other._root), _size(other._size), _cmp(other._cmp), _alloc(other._alloc), 
+        _nodeAlloc(other._nodeAlloc), _batches(std::move(other._batches))
     {
-        other->root = nullptr;
-        other->_size = 0;
+        other._root = nullptr;
+        other._size = 0;
     }
-    AVLTree(AVLTree&& other, const Allocator& alloc):
-        _root(other->_root), _size(other->_size), _cmp(other->_cmp), 
-        _alloc(alloc)
+    // nodes are copied if they can not be given back by alloc
+    AVLTree(AVLTree&& other, const Allocator& alloc): AVLTree(other._cmp, alloc)
     {
-        other->root = nullptr;
-        other->_size = 0;
+        auto size = other._size;
+        _setRoot(_takeNodes(other), size);
     }
     AVLTree(std::initializer_list<value_type> init,
         const Compare& comp = Compare(),
         const Allocator& alloc = Allocator()):
-        _root(nullptr), _size(0), _cmp(comp), _alloc()
+        AVLTree(comp, alloc)
     {
-        for (auto i = init.begin(); i != init.end(); i++)
-            insert(std::move(*i));
+        insert(init.begin(), init.end());
     }
 
     ~AVLTree()
@@ -699,17 +729,41 @@ public:
         clear();
     }
 
+    // comparator is copied with the keys, the allocator stays the same
+    AVLTree& operator=(const AVLTree& other)
+    {
+        if (this == &other)
+            return *this;
+
+        clear();
+        _cmp = other._cmp;
+        _mergeSorted(const_left_root_right_iterator(other.begin()), 
+            const_left_root_right_iterator(other.end()));
+        return *this;
+    }
+    AVLTree& operator=(AVLTree&& other)
+    {
+        if (this == &other)
+            return *this;
+
+        clear();
+        _cmp = std::move(other._cmp);
+        auto size = other._size;
+        _setRoot(_takeNodes(other), size);
+        return *this;
+    }
+
     iterator begin() noexcept
     {
         return iterator(_root);
     }
     const_iterator begin() const noexcept
     {
-        return const_iterator(_root);
+        return const_iterator((typename const_iterator::node_pointer)_root);
     }
     const_iterator cbegin() const noexcept
     {
-        return const_iterator(_root);
+        return const_iterator((typename const_iterator::node_pointer)_root);
     }
 
     iterator end() noexcept
@@ -734,431 +788,308 @@ public:
         return _size;
     }
 
-    void clear() noexcept
+    allocator_type get_allocator() const noexcept
+    {
+        return _alloc;
+    }
+    key_compare key_comp() const
     {
-        for (; !empty();)
-            erase(begin());
+        return _cmp;
+    }
+    value_compare value_comp() const
+    {
+        return _cmp;
     }
 
-    std::pair<iterator,bool> insert(const value_type& value)
+    void clear() noexcept
     {
-        if (_root == nullptr)
+        // deleting nodes in LRN order, children before their parent
+        for (auto n = _root; n != nullptr;)
         {
-            // creating first node
-            _root = _createNode(value);
-            _size++;
-            return { iterator(_root), true };
+            if (n->left != nullptr)
+                n = n->left;
+            else if (n->right != nullptr)
+                n = n->right;
+            else
+            {
+                auto parent = n->parent;
+                if (parent != nullptr)
+                    parent->left == n ? parent->left = nullptr : parent->right = nullptr;
+                
+                _deleteNode(n);
+                n = parent;
+            }
         }
+        _root = nullptr;
+        _size = 0;
+        // batch memory is given back when the last tree using it is cleared
+        _batches.resize(0);
+    }
 
-        value_compare cmp;
-        Stack<node_pointer> path = _getPathToNode(value);
-        if (path.top() != nullptr && path.top()->value != value)
-            throw std::logic_error("some error in finding path in insertion");
-
-        if (path.top() != nullptr && path.top()->value == value)
-            // path.top()->value == value => this value already exists
-            return { iterator(path.top()), false };
-    
-        path.pop();
-        // create new node
-        auto newNode = _createNode(value);
-        _cmp(path.top()->value, value) ? path.top()->right = newNode : path.top()->left = newNode;
-        _size++;
-        
-        for (; !path.empty();)
-        {
-            auto node = path.top();
-            path.pop();
-            node->height = std::max(_getHeight(node->left), _getHeight(node->right)) + 1;
-            auto balance = _getLeftRightDiff(node);
-            node_pointer newSubRoot;
-            if (balance > 1 && newNode->value < node->left->value)
-                newSubRoot = _rightRotation(node);
-            else if (balance < -1 && _cmp(node->right->value, newNode->value))
-                newSubRoot = _leftRotation(node);
-            else if (balance > 1 && _cmp(node->left->value, newNode->value))
-                newSubRoot = _leftRightRotation(node);
-            else if (balance < -1 && newNode->value < node->right->value)
-                newSubRoot = _rightLeftRotation(node);
-            else
-                continue;
+    // builds perfectly balanced tree in O(n), [first, last) must be sorted and unique
+    template < typename ForwardIt >
+    void assign_sorted(ForwardIt first, ForwardIt last)
+    {
+        clear();
+        _mergeSorted(first, last);
+    }
 
-            if (!path.empty())
-                _cmp(path.top()->value, newSubRoot->value) ? 
-                    path.top()->right = newSubRoot : path.top()->left = newSubRoot;
-            else
-                _root = newSubRoot;
-        }
-        return { iterator(newNode), true };
+    // insert returns the existing node if there is such key, tree is not changed then
+    std::pair<iterator,bool> insert(const value_type& value)
+    {
+        return _insertOrFind(value, value);
     }
     std::pair<iterator,bool> insert(value_type&& value)
     {
-        if (_root == nullptr)
-        {
-            // creating first node
-            _root = _createNode(std::move(value));
-            _size++;
-            return { iterator(_root), true };
-        }
-
-        value_compare cmp;
-        Stack<node_pointer> path = _getPathToNode(value);
-        if (path.top() != nullptr && path.top()->value != value)
-            throw std::logic_error("some error in finding path in insertion");
-
-        if (path.top() != nullptr && path.top()->value == value)
-            // path.top()->value == value => this value already exists
-            return { iterator(path.top()), false };
-    
-        path.pop();
-        // create new node
-        auto newNode = _createNode(std::move(value));
-        _cmp(path.top()->value, value) ? path.top()->right = newNode : path.top()->left = newNode;
-        _size++;
-        
-        for (; !path.empty();)
-        {
-            auto node = path.top();
-            path.pop();
-            node->height = std::max(_getHeight(node->left), _getHeight(node->right)) + 1;
-            auto balance = _getLeftRightDiff(node);
-            node_pointer newSubRoot;
-            if (balance > 1 && newNode->value < node->left->value)
-                newSubRoot = _rightRotation(node);
-            else if (balance < -1 && _cmp(node->right->value, newNode->value))
-                newSubRoot = _leftRotation(node);
-            else if (balance > 1 && _cmp(node->left->value, newNode->value))
-                newSubRoot = _leftRightRotation(node);
-            else if (balance < -1 && newNode->value < node->right->value)
-                newSubRoot = _rightLeftRotation(node);
-            else
-                continue;
+        return _insertOrFind(value, std::move(value));
+    }
+    // Key is constructed from key only if there is no such key in the tree
+    template < typename K, typename C = Compare, typename = typename C::is_transparent,
+        typename = typename std::enable_if<!std::is_convertible<K&&, const_iterator>::value>::type >
+    std::pair<iterator,bool> insert(K&& key)
+    {
+        return _insertOrFind(key, std::forward<K>(key));
+    }
 
-            if (!path.empty())
-                _cmp(path.top()->value, newSubRoot->value) ? 
-                    path.top()->right = newSubRoot : path.top()->left = newSubRoot;
-            else
-                _root = newSubRoot;
-        }
-        return { iterator(newNode), true };
+    // value is constructed from args only if there is no key equal to it,
+    // key is used for the search; std::invalid_argument is thrown if the
+    // constructed value is not equal to key
+    template < typename... Args >
+    std::pair<iterator,bool> try_emplace(const Key& key, Args&&... args)
+    {
+        return _insertOrFind<true>(key, std::forward<Args>(args)...);
+    }
+    template < typename K, typename... Args, typename C = Compare, 
+        typename = typename C::is_transparent >
+    std::pair<iterator,bool> try_emplace(const K& key, Args&&... args)
+    {
+        return _insertOrFind<true>(key, std::forward<Args>(args)...);
     }
 
-    template < typename K >
-    size_type erase(K&& key)
+    // sorts and deduplicates the batch, then merges it into the tree:
+    // the tree is rebuilt in O(n + m) if the batch is big enough
+    template < typename InputIt >
+    void insert(InputIt first, InputIt last)
     {
-        // buid the stack
-        value_compare cmp;
-        Stack<node_pointer> path = _getPathToNode(key);
-        if (path.empty())
-            return 0;
+        DynArr<value_type, Allocator> batch(_alloc);
+        batch.append(first, last);
 
-        node_pointer n = path.top();
-        path.pop();
-        // n->value == key, we delete this node
-        if (n->left == nullptr || n->right == nullptr)
-        {
-            // deleting leaf or node with one child
-            if (n->left == nullptr)
-                if (!path.empty())
-                    cmp(n->value, path.top()->value) ? 
-                        path.top()->left = n->right : path.top()->right = n->right;
-                else
-                    // deleting root
-                    _root = n->right;
-
-            if (n->right == nullptr)
-                if (!path.empty())
-                    cmp(n->value, path.top()->value) ? 
-                        path.top()->left = n->left : path.top()->right = n->left;
-                else
-                    // deleting root
-                    _root = n->left;
-        }
-        else
-        {
-            // deleting node with two children
-            node_pointer prevNode = path.empty() ? nullptr : path.top();
-            // finding nearest value
-            Stack<node_pointer> subPath;
-            auto minNode = n->right;
-            for (; minNode->left;)
-            {
-                subPath.push(minNode);
-                minNode = minNode->left;
-            }
-            
-            if (!subPath.empty())
-                subPath.top()->left == minNode ? 
-                    subPath.top()->left = minNode->right : subPath.top()->right = minNode->right;
-            else
-                n->right = minNode->right;
-                
-            // moving nearest node to this place
-            auto node = minNode;
-            node->left = n->left;
-            node->right = n->right;
-            if (prevNode != nullptr)
-                cmp(prevNode->value, node->value) ? 
-                    prevNode->right = node : prevNode->left = node;
-            else
-                // deleting root
-                _root = node;
+        if (batch.empty())
+            return;
 
-            // update heights
-            path.push(node);
-            for (; !subPath.empty();)
+        timSort(batch.begin(), batch.end(), _cmp);
+        // removing duplicates
+        size_type count = 1;
+        for (size_type i = 1; i < batch.size(); i++)
+            if (_cmp(batch[count - 1], batch[i]))
             {
-                subPath.top()->height = std::max(_getHeight(subPath.top()->left),
-                    _getHeight(subPath.top()->right)) + 1;
-                auto newSubRoot = _makeRotation(subPath);
-                subPath.pop();
-                if (!subPath.empty())
-                    _cmp(subPath.top()->value, newSubRoot->value) ? 
-                        subPath.top()->right = newSubRoot : subPath.top()->left = newSubRoot;
-                else
-                    _cmp(path.top()->value, newSubRoot->value) ? 
-                        path.top()->right = newSubRoot : path.top()->left = newSubRoot;
+                if (count != i)
+                    batch[count] = std::move(batch[i]);
+                count++;
             }
-        }
-        // update heigts
-        for (; !path.empty();)
+        batch.resize(count);
+
+        if (count * (_getHeight(_root) + 1) < size() + count)
         {
-            path.top()->height = std::max(_getHeight(path.top()->left), 
-                _getHeight(path.top()->right)) + 1;
-            auto newSubRoot = _makeRotation(path);
-            path.pop();
-            if (!path.empty())
-                _cmp(path.top()->value, newSubRoot->value) ? 
-                    path.top()->right = newSubRoot : path.top()->left = newSubRoot;
-            else
-                _root = newSubRoot;
+            // few new keys, inserting one by one is cheaper
+            for (size_type i = 0; i < count; i++)
+                insert(std::move(batch[i]));
+            return;
         }
-        _deleteNode(n);
-        _size--;
-        return 1;
+        _mergeSorted(std::make_move_iterator(batch.begin()), std::make_move_iterator(batch.end()));
+    }
+
+    size_type erase(const Key& key)
+    {
+        return _eraseKey(key);
+    }
+    template < typename K, typename C = Compare, typename = typename C::is_transparent,
+        typename = typename std::enable_if<!std::is_convertible<K&&, const_iterator>::value>::type >
+    size_type erase(K&& key)
+    {
+        return _eraseKey(key);
     }
     void erase(iterator pos)
     {
-        if (pos == end() || _root == nullptr)
-            return;
-        
-        // buid the stack
-        value_compare cmp;
-        Stack<node_pointer> path = _getPathToNode(*pos);
-        if (path.empty())
+        if (pos == end())
             return;
 
-        node_pointer n = path.top();
-        path.pop();
-        // n->value == *pos, we delete this node
-        if (n->left == nullptr || n->right == nullptr)
-        {
-            // deleting leaf or node with one child
-            if (n->left == nullptr)
-                if (!path.empty())
-                    cmp(n->value, path.top()->value) ? 
-                        path.top()->left = n->right : path.top()->right = n->right;
-                else
-                    // deleting root
-                    _root = n->right;
-
-            if (n->right == nullptr)
-                if (!path.empty())
-                    cmp(n->value, path.top()->value) ? 
-                        path.top()->left = n->left : path.top()->right = n->left;
-                else
-                    // deleting root
-                    _root = n->left;
-        }
-        else
-        {
-            // deleting node with two children
-            node_pointer prevNode = path.empty() ? nullptr : path.top();
-            // finding nearest value
-            Stack<node_pointer> subPath;
-            auto minNode = n->right;
-            for (; minNode->left;)
-            {
-                subPath.push(minNode);
-                minNode = minNode->left;
-            }
-            
-            if (!subPath.empty())
-                subPath.top()->left == minNode ? 
-                    subPath.top()->left = minNode->right : subPath.top()->right = minNode->right;
-            else
-                n->right = minNode->right;
-                
-            // moving nearest node to this place
-            auto node = minNode;
-            node->left = n->left;
-            node->right = n->right;
-            if (prevNode != nullptr)
-                cmp(prevNode->value, node->value) ? 
-                    prevNode->right = node : prevNode->left = node;
-            else
-                // deleting root
-                _root = node;
-
-            // update heights
-            path.push(node);
-            for (; !subPath.empty();)
-            {
-                subPath.top()->height = std::max(_getHeight(subPath.top()->left),
-                    _getHeight(subPath.top()->right)) + 1;
-                auto newSubRoot = _makeRotation(subPath);
-                subPath.pop();
-                if (!subPath.empty())
-                    _cmp(subPath.top()->value, newSubRoot->value) ? 
-                        subPath.top()->right = newSubRoot : subPath.top()->left = newSubRoot;
-                else
-                    _cmp(path.top()->value, newSubRoot->value) ? 
-                        path.top()->right = newSubRoot : path.top()->left = newSubRoot;
-            }
-        }
-        // update heigts
-        for (; !path.empty();)
-        {
-            path.top()->height = std::max(_getHeight(path.top()->left), 
-                _getHeight(path.top()->right)) + 1;
-            auto newSubRoot = _makeRotation(path);
-            path.pop();
-            if (!path.empty())
-                _cmp(path.top()->value, newSubRoot->value) ? 
-                    path.top()->right = newSubRoot : path.top()->left = newSubRoot;
-            else
-                _root = newSubRoot;
-        }
-        _deleteNode(n);
-        _size--;
+        _eraseNode(pos._getNodePointer());
     }
     void erase(const_iterator pos)
     {
-        if (pos == end() || _root == nullptr)
-            return;
-        
-        // buid the stack
-        value_compare cmp;
-        Stack<node_pointer> path = _getPathToNode(*pos);
-        if (path.empty())
+        if (pos == cend())
             return;
 
-        node_pointer n = path.top();
-        path.pop();
-        // n->value == *pos, we delete this node
-        if (n->left == nullptr || n->right == nullptr)
-        {
-            // deleting leaf or node with one child
-            if (n->left == nullptr)
-                if (!path.empty())
-                    cmp(n->value, path.top()->value) ? 
-                        path.top()->left = n->right : path.top()->right = n->right;
-                else
-                    // deleting root
-                    _root = n->right;
-
-            if (n->right == nullptr)
-                if (!path.empty())
-                    cmp(n->value, path.top()->value) ? 
-                        path.top()->left = n->left : path.top()->right = n->left;
-                else
-                    // deleting root
-                    _root = n->left;
-        }
-        else
-        {
-            // deleting node with two children
-            node_pointer prevNode = path.empty() ? nullptr : path.top();
-            // finding nearest value
-            Stack<node_pointer> subPath;
-            auto minNode = n->right;
-            for (; minNode->left;)
-            {
-                subPath.push(minNode);
-                minNode = minNode->left;
-            }
-            
-            if (!subPath.empty())
-                subPath.top()->left == minNode ? 
-                    subPath.top()->left = minNode->right : subPath.top()->right = minNode->right;
-            else
-                n->right = minNode->right;
-                
-            // moving nearest node to this place
-            auto node = minNode;
-            node->left = n->left;
-            node->right = n->right;
-            if (prevNode != nullptr)
-                cmp(prevNode->value, node->value) ? 
-                    prevNode->right = node : prevNode->left = node;
-            else
-                // deleting root
-                _root = node;
-
-            // update heights
-            path.push(node);
-            for (; !subPath.empty();)
-            {
-                subPath.top()->height = std::max(_getHeight(subPath.top()->left),
-                    _getHeight(subPath.top()->right)) + 1;
-                auto newSubRoot = _makeRotation(subPath);
-                subPath.pop();
-                if (!subPath.empty())
-                    _cmp(subPath.top()->value, newSubRoot->value) ? 
-                        subPath.top()->right = newSubRoot : subPath.top()->left = newSubRoot;
-                else
-                    _cmp(path.top()->value, newSubRoot->value) ? 
-                        path.top()->right = newSubRoot : path.top()->left = newSubRoot;
-            }
-        }
-        // update heigts
-        for (; !path.empty();)
-        {
-            path.top()->height = std::max(_getHeight(path.top()->left), 
-                _getHeight(path.top()->right)) + 1;
-            auto newSubRoot = _makeRotation(path);
-            path.pop();
-            if (!path.empty())
-                _cmp(path.top()->value, newSubRoot->value) ? 
-                    path.top()->right = newSubRoot : path.top()->left = newSubRoot;
-            else
-                _root = newSubRoot;
-        }
-        _deleteNode(n);
-        _size--;
+        _eraseNode((node_pointer)pos._getNodePointer());
     }
 
     iterator find(const Key& key)
     {
-        for (auto i = _root;;)
-        {
-            if (i == nullptr)
-                return end();
-            else if (cmp(key, i->value))
-                i = i->left;
-            else if (cmp(i->value, key))
-                i = i->right;
-            else
-                // i->value == value => this value already exists
-                return iterator(i);
-        }
-        return end();
+        node_pointer parent;
+        return iterator(_findNode(key, parent));
     }
     const_iterator find(const Key& key) const
     {
-        for (auto i = _root;;)
+        node_pointer parent;
+        return const_iterator((typename const_iterator::node_pointer)_findNode(key, parent));
+    }
+    // lookup by any type comparable with Key, without constructing Key
+    template < typename K, typename C = Compare, typename = typename C::is_transparent >
+    iterator find(const K& key)
+    {
+        node_pointer parent;
+        return iterator(_findNode(key, parent));
+    }
+    template < typename K, typename C = Compare, typename = typename C::is_transparent >
+    const_iterator find(const K& key) const
+    {
+        node_pointer parent;
+        return const_iterator((typename const_iterator::node_pointer)_findNode(key, parent));
+    }
+
+    // number of keys less than key (position in sorted order) or size() if there is no such key
+    size_type rank(const Key& key) const
+    {
+        static_assert(OrderStatistics, "AVLTree::rank needs OrderStatistics");
+        size_type less = 0;
+        for (const_node_pointer i = _root; i != nullptr;)
         {
-            if (i == nullptr)
-                return cend();
-            else if (cmp(key, i->value))
+            if (_cmp(key, i->value))
                 i = i->left;
-            else if (cmp(i->value, key))
+            else if (_cmp(i->value, key))
+            {
+                less += _getCount(i->left) + 1;
                 i = i->right;
+            }
             else
-                // i->value == value => this value already exists
-                return const_iterator(i);
+                return less + _getCount(i->left);
         }
-        return cend();
+        return size();
+    }
+
+    // number of keys in [low, high)
+    size_type count_range(const Key& low, const Key& high) const
+    {
+        if (!_cmp(low, high))
+            return 0;
+
+        return _countLess(high) - _countLess(low);
+    }
+
+    // the first key which is not less than key
+    left_root_right_iterator lower_bound(const Key& key)
+    {
+        return left_root_right_iterator::_at(_lowerBoundNode(key));
+    }
+    const_left_root_right_iterator lower_bound(const Key& key) const
+    {
+        auto nodeP = (typename const_iterator::node_pointer)_lowerBoundNode(key);
+        return const_left_root_right_iterator::_at(nodeP);
+    }
+
+    // the first key which is greater than key
+    left_root_right_iterator upper_bound(const Key& key)
+    {
+        return left_root_right_iterator::_at(_upperBoundNode(key));
+    }
+    const_left_root_right_iterator upper_bound(const Key& key) const
+    {
+        auto nodeP = (typename const_iterator::node_pointer)_upperBoundNode(key);
+        return const_left_root_right_iterator::_at(nodeP);
+    }
+
+    std::pair<left_root_right_iterator, left_root_right_iterator> equal_range(const Key& key)
+    {
+        return { lower_bound(key), upper_bound(key) };
+    }
+    std::pair<const_left_root_right_iterator, const_left_root_right_iterator> 
+        equal_range(const Key& key) const
+    {
+        return { lower_bound(key), upper_bound(key) };
+    }
+
+    // keys in [low, high) in sorted order, the first one is found in O(log n)
+    std::pair<left_root_right_iterator, left_root_right_iterator> 
+        range(const Key& low, const Key& high)
+    {
+        if (!_cmp(low, high))
+            return { upper_bound(low), upper_bound(low) };
+
+        return { lower_bound(low), lower_bound(high) };
+    }
+    std::pair<const_left_root_right_iterator, const_left_root_right_iterator> 
+        range(const Key& low, const Key& high) const
+    {
+        if (!_cmp(low, high))
+            return { upper_bound(low), upper_bound(low) };
+
+        return { lower_bound(low), lower_bound(high) };
+    }
+
+    // key with rank k or end() if k >= size()
+    iterator select(size_type k)
+    {
+        return iterator(_selectNode(k));
+    }
+    const_iterator select(size_type k) const
+    {
+        return const_iterator((typename const_iterator::node_pointer)_selectNode(k));
+    }
+
+    // join and split work in O(log n), nodes are moved between trees without copying
+
+    // all keys of this tree < key < all keys of right, right becomes empty
+    void join(const value_type& key, AVLTree&& right)
+    {
+        _joinWith(_createNode(key), std::move(right));
+    }
+    void join(value_type&& key, AVLTree&& right)
+    {
+        _joinWith(_createNode(std::move(key)), std::move(right));
+    }
+    // all keys of this tree < all keys of right, right becomes empty
+    void join(AVLTree&& right)
+    {
+        _joinWith(nullptr, std::move(right));
+    }
+
+    // keys which are not less than key are moved to the returned tree
+    AVLTree split(const Key& key)
+    {
+        static_assert(OrderStatistics, "AVLTree::split needs OrderStatistics");
+        AVLTree greaterTree(_cmp, _alloc);
+        for (size_type i = 0; i < _batches.size(); i++)
+            greaterTree._batches.push_back(_batches[i]);
+
+        node_pointer less, greater;
+        auto found = _split(_root, key, less, greater);
+        if (found != nullptr)
+            greater = _join(nullptr, found, greater);
+
+        _setRoot(less);
+        greaterTree._setRoot(greater);
+        return greaterTree;
+    }
+
+    // set operations: other becomes empty, big trees are processed by several threads
+    // other must be ordered by an equivalent comparator, _cmp is called from several threads
+    // https://arxiv.org/abs/1602.02120
+
+    // adds keys of other which are not in this tree
+    void unite(AVLTree&& other)
+    {
+        _setOperation(SetOperation::Union, std::move(other));
+    }
+    // leaves only keys which are in other too
+    void intersect(AVLTree&& other)
+    {
+        _setOperation(SetOperation::Intersection, std::move(other));
+    }
+    // removes keys which are in other
+    void subtract(AVLTree&& other)
+    {
+        _setOperation(SetOperation::Difference, std::move(other));
     }
 
     // node_pointer __getRoot()
@@ -1181,31 +1112,233 @@ private:
 
         return _getHeight(x->left) - _getHeight(x->right);
     }
+    static size_t _getCount(const_node_pointer x)
+    {
+        if (x == nullptr)
+            return 0;
 
-    Stack<node_pointer> _getPathToNode(const value_type& key)
+        return x->count;
+    }
+    // height and count are recalculated from children
+    void _updateNode(node_pointer x)
+    {
+        x->height = std::max(_getHeight(x->left), _getHeight(x->right)) + 1;
+        if constexpr (OrderStatistics)
+            x->count = _getCount(x->left) + _getCount(x->right) + 1;
+    }
+
+    size_type _countLess(const Key& key) const
+    {
+        static_assert(OrderStatistics, "AVLTree::count_range needs OrderStatistics");
+        size_type less = 0;
+        for (auto i = _root; i != nullptr;)
+        {
+            if (_cmp(i->value, key))
+            {
+                less += _getCount(i->left) + 1;
+                i = i->right;
+            }
+            else
+                i = i->left;
+        }
+        return less;
+    }
+
+    node_pointer _lowerBoundNode(const Key& key) const
     {
-        value_compare cmp;
-        Stack<node_pointer> path;
-        for (auto i = _root;;)
+        node_pointer bound = nullptr;
+        for (auto i = _root; i != nullptr;)
         {
-            path.push(i);
-            if (i == nullptr)
-                // did not find
-                return path;
-            else if (cmp(key, i->value))
+            if (_cmp(i->value, key))
+                i = i->right;
+            else
+            {
+                bound = i;
+                i = i->left;
+            }
+        }
+        return bound;
+    }
+
+    node_pointer _upperBoundNode(const Key& key) const
+    {
+        node_pointer bound = nullptr;
+        for (auto i = _root; i != nullptr;)
+        {
+            if (_cmp(key, i->value))
+            {
+                bound = i;
+                i = i->left;
+            }
+            else
+                i = i->right;
+        }
+        return bound;
+    }
+
+    node_pointer _selectNode(size_type k) const
+    {
+        static_assert(OrderStatistics, "AVLTree::select needs OrderStatistics");
+        for (auto i = _root; i != nullptr;)
+        {
+            auto leftCount = _getCount(i->left);
+            if (k < leftCount)
+                i = i->left;
+            else if (k > leftCount)
+            {
+                k -= leftCount + 1;
+                i = i->right;
+            }
+            else
+                return i;
+        }
+        return nullptr;
+    }
+
+    // returns node with this key or nullptr, parent is the last visited node
+    template < typename K >
+    node_pointer _findNode(const K& key, node_pointer& parent) const
+    {
+        parent = nullptr;
+        for (auto i = _root; i != nullptr;)
+        {
+            if (_cmp(key, i->value))
+            {
                 // go left
+                parent = i;
                 i = i->left;
-            else if (cmp(i->value, key))
+            }
+            else if (_cmp(i->value, key))
+            {
                 // go right
+                parent = i;
                 i = i->right;
+            }
             else
                 // found this key
-                return path;
+                return i;
+        }
+        return nullptr;
+    }
+
+    // puts newNode in place of oldNode in the parent (or in the root)
+    void _replaceChild(node_pointer parent, node_pointer oldNode, node_pointer newNode)
+    {
+        if (parent == nullptr)
+            _root = newNode;
+        else if (parent->left == oldNode)
+            parent->left = newNode;
+        else
+            parent->right = newNode;
+
+        if (newNode != nullptr)
+            newNode->parent = parent;
+    }
+
+    void _attachNode(node_pointer parent, node_pointer newNode)
+    {
+        if (parent == nullptr)
+            // creating first node
+            _root = newNode;
+        else
+            _cmp(parent->value, newNode->value) ? parent->right = newNode : parent->left = newNode;
+
+        newNode->parent = parent;
+        _size++;
+        _rebalance(parent);
+    }
+
+    // one search from the root, node is created only if key is not found;
+    // with CheckKey the value built from args is compared with key
+    // (insert moves from key, so it is not checked there)
+    template < bool CheckKey = false, typename K, typename... Args >
+    std::pair<iterator,bool> _insertOrFind(const K& key, Args&&... args)
+    {
+        node_pointer parent;
+        auto n = _findNode(key, parent);
+        if (n != nullptr)
+            // this value already exists
+            return { iterator(n), false };
+
+        node_pointer newNode;
+        if constexpr (sizeof...(Args) == 0)
+            newNode = _createNode(key);
+        else
+        {
+            newNode = _createNode(std::forward<Args>(args)...);
+            // parent was found for key, so the value must be equal to it
+            if constexpr (CheckKey)
+                if (_cmp(newNode->value, key) || _cmp(key, newNode->value))
+                {
+                    _deleteNode(newNode);
+                    throw std::invalid_argument("AVLTree::try_emplace: value is not equal to key");
+                }
+        }
+
+        _attachNode(parent, newNode);
+        return { iterator(newNode), true };
+    }
+
+    template < typename K >
+    size_type _eraseKey(const K& key)
+    {
+        node_pointer parent;
+        auto n = _findNode(key, parent);
+        if (n == nullptr)
+            // there is no such key
+            return 0;
+
+        _eraseNode(n);
+        return 1;
+    }
+
+    void _eraseNode(node_pointer n)
+    {
+        auto parent = n->parent;
+        auto rebalanceFrom = parent;
+        if (n->left == nullptr || n->right == nullptr)
+            // deleting leaf or node with one child
+            _replaceChild(parent, n, n->left != nullptr ? n->left : n->right);
+        else
+        {
+            // deleting node with two children, nearest greater node takes its place
+            auto minNode = n->right;
+            for (; minNode->left != nullptr;)
+                minNode = minNode->left;
+
+            rebalanceFrom = minNode;
+            if (minNode->parent != n)
+            {
+                rebalanceFrom = minNode->parent;
+                _replaceChild(minNode->parent, minNode, minNode->right);
+                minNode->right = n->right;
+                minNode->right->parent = minNode;
+            }
+            minNode->left = n->left;
+            minNode->left->parent = minNode;
+            minNode->height = n->height;
+            if constexpr (OrderStatistics)
+                minNode->count = n->count;
+            _replaceChild(parent, n, minNode);
         }
+        _rebalance(rebalanceFrom);
+        _deleteNode(n);
+        _size--;
     }
-    Stack<node_pointer> _getPathToNode(iterator it)
+
+    // updating heights and making rotations from node up to the root
+    void _rebalance(node_pointer node)
     {
-        return _getPathToNode(*it);
+        for (; node != nullptr;)
+        {
+            auto parent = node->parent;
+            _updateNode(node);
+            auto newSubRoot = _makeRotation(node);
+            if (newSubRoot != node)
+                _replaceChild(parent, node, newSubRoot);
+
+            node = parent;
+        }
     }
 
     node_pointer _leftRotation(node_pointer a)
@@ -1218,9 +1351,14 @@ private:
         // rotation
         b->left = a;
         a->right = c;
-        // change heights
-        a->height = std::max(_getHeight(a->left), _getHeight(a->right)) + 1;
-        b->height = std::max(_getHeight(b->left), _getHeight(b->right)) + 1;
+        // change parents
+        if (c != nullptr)
+            c->parent = a;
+        b->parent = a->parent;
+        a->parent = b;
+        // change heights and counts
+        _updateNode(a);
+        _updateNode(b);
         return b;
     }
     node_pointer _rightRotation(node_pointer a)
@@ -1233,9 +1371,14 @@ private:
         // rotation
         b->right = a;
         a->left = c;
-        // change heights
-        a->height = std::max(_getHeight(a->left), _getHeight(a->right)) + 1;
-        b->height = std::max(_getHeight(b->left), _getHeight(b->right)) + 1;
+        // change parents
+        if (c != nullptr)
+            c->parent = a;
+        b->parent = a->parent;
+        a->parent = b;
+        // change heights and counts
+        _updateNode(a);
+        _updateNode(b);
         return b;
     }
     node_pointer _leftRightRotation(node_pointer a)
@@ -1255,9 +1398,8 @@ private:
         return _leftRotation(a);
     }
 
-    node_pointer _makeRotation(Stack<node_pointer>& path)
+    node_pointer _makeRotation(node_pointer root)
     {
-        auto root = path.top();
         int balance = _getLeftRightDiff(root);
         if (balance > 1 && _getLeftRightDiff(root->left) >= 0)
             return _rightRotation(root);
@@ -1271,31 +1413,370 @@ private:
         return root;
     }
 
-    node_pointer _createNode(const value_type& value)
+    // value of node is constructed from args
+    template < typename... Args >
+    node_pointer _createNode(Args&&... args)
     {
         node_pointer nodeP = traits<NodeAllocator>::allocate(_nodeAlloc, 1);
-        traits<NodeAllocator>::construct(_nodeAlloc, nodeP, value, nullptr, nullptr, 1);
-        return nodeP;
-    }
-    node_pointer _createNode(value_type&& value)
-    {
-        node_pointer nodeP = traits<NodeAllocator>::allocate(_nodeAlloc, 1);
-        traits<NodeAllocator>::construct(_nodeAlloc, nodeP, value, nullptr, nullptr, 1);
+        try
+        {
+            traits<NodeAllocator>::construct(_nodeAlloc, nodeP, std::in_place, 
+                std::forward<Args>(args)...);
+        }
+        catch(...)
+        {
+            traits<NodeAllocator>::deallocate(_nodeAlloc, nodeP, 1);
+            throw;
+        }
         return nodeP;
     }
 
     void _deleteNode(node_pointer nodeP)
     {
         traits<NodeAllocator>::destroy(_nodeAlloc, nodeP);
+        // memory of batch nodes is given back only all at once in clear()
+        std::less<node_pointer> less;
+        for (size_type i = 0; i < _batches.size(); i++)
+        {
+            auto batch = _batches[i].first.get();
+            if (!less(nodeP, batch) && less(nodeP, batch + _batches[i].second))
+                return;
+        }
         traits<NodeAllocator>::deallocate(_nodeAlloc, nodeP, 1);
     }
 
+    // merges sorted unique keys with the keys of the tree and rebuilds it
+    // new nodes are allocated by one call
+    template < typename ForwardIt >
+    void _mergeSorted(ForwardIt first, ForwardIt last)
+    {
+        DynArr<node_pointer, NodePointerAllocator> oldNodes(_nodeAlloc);
+        for (left_root_right_iterator i(_root); i != end(); i++)
+            oldNodes.push_back(i._getNodePointer());
+
+        // counting new keys
+        size_type newCount = 0;
+        size_type j = 0;
+        for (auto i = first; i != last; i++)
+        {
+            for (; j < oldNodes.size() && _cmp(oldNodes[j]->value, *i); j++)
+            {}
+            if (j == oldNodes.size() || _cmp(*i, oldNodes[j]->value))
+                newCount++;
+        }
+        if (newCount == 0)
+            return;
+
+        node_pointer batch = traits<NodeAllocator>::allocate(_nodeAlloc, newCount);
+        _batches.push_back(batch_type(std::shared_ptr<node_type>(batch, 
+            BatchDeleter{ _nodeAlloc, newCount }, _alloc), newCount));
+        
+        DynArr<node_pointer, NodePointerAllocator> nodes(_nodeAlloc);
+        size_type created = 0;
+        try
+        {
+            j = 0;
+            for (auto i = first; i != last; i++)
+            {
+                for (; j < oldNodes.size() && _cmp(oldNodes[j]->value, *i); j++)
+                    nodes.push_back(oldNodes[j]);
+                
+                if (j < oldNodes.size() && !_cmp(*i, oldNodes[j]->value))
+                    // this key already exists
+                    continue;
+
+                node_pointer nodeP = batch + created;
+                traits<NodeAllocator>::construct(_nodeAlloc, nodeP, *i, nullptr, nullptr, nullptr, 1, 1);
+                created++;
+                nodes.push_back(nodeP);
+            }
+            for (; j < oldNodes.size(); j++)
+                nodes.push_back(oldNodes[j]);
+        }
+        catch(...)
+        {
+            // tree is not changed yet, the batch is given back
+            for (size_type k = 0; k < created; k++)
+                traits<NodeAllocator>::destroy(_nodeAlloc, batch + k);
+            _batches.pop_back();
+            throw;
+        }
+
+        _root = _linkBalanced(nodes, 0, nodes.size(), nullptr);
+        _size = nodes.size();
+    }
+
+    // nodes[mid] becomes root of [lo, hi)
+    node_pointer _linkBalanced(DynArr<node_pointer, NodePointerAllocator>& nodes, 
+        size_type lo, size_type hi, node_pointer parent)
+    {
+        if (lo >= hi)
+            return nullptr;
+
+        auto mid = lo + (hi - lo) / 2;
+        auto node = nodes[mid];
+        node->parent = parent;
+        node->left = _linkBalanced(nodes, lo, mid, node);
+        node->right = _linkBalanced(nodes, mid + 1, hi, node);
+        _updateNode(node);
+        return node;
+    }
+
+    void _setRoot(node_pointer root) noexcept
+    {
+        _setRoot(root, _getCount(root));
+    }
+    void _setRoot(node_pointer root, size_type size) noexcept
+    {
+        if (root != nullptr)
+            root->parent = nullptr;
+
+        _root = root;
+        _size = size;
+    }
+
+    // nodes of other are moved to this tree, other becomes empty
+    node_pointer _takeNodes(AVLTree& other)
+    {
+        if (!(_nodeAlloc == other._nodeAlloc))
+        {
+            // nodes can not be given back by another allocator, copying them
+            AVLTree copy(other, _alloc);
+            other.clear();
+            return _takeNodes(copy);
+        }
+        for (size_type i = 0; i < other._batches.size(); i++)
+        {
+            bool shared = false;
+            for (size_type j = 0; j < _batches.size(); j++)
+                if (_batches[j].first == other._batches[i].first)
+                    shared = true;
+
+            if (!shared)
+                _batches.push_back(other._batches[i]);
+        }
+        auto root = other._root;
+        other._root = nullptr;
+        other._size = 0;
+        other._batches.resize(0);
+        return root;
+    }
+
+    void _joinWith(node_pointer mid, AVLTree&& right)
+    {
+        static_assert(OrderStatistics, "AVLTree::join needs OrderStatistics");
+        auto rightRoot = _takeNodes(right);
+        _setRoot(mid != nullptr ? _join(_root, mid, rightRoot) : _join(_root, rightRoot));
+    }
+
+    void _setOperation(SetOperation op, AVLTree&& other)
+    {
+        static_assert(OrderStatistics, "AVLTree set operations need OrderStatistics");
+        auto otherRoot = _takeNodes(other);
+        unsigned depth = 0;
+        for (auto n = std::thread::hardware_concurrency(); n > 1; n >>= 1)
+            depth++;
+
+        node_pointer dropped = nullptr;
+        _setRoot(_setOperation(op, _root, otherRoot, depth, dropped));
+        for (; dropped != nullptr;)
+        {
+            auto next = dropped->parent;
+            _deleteNode(dropped);
+            dropped = next;
+        }
+    }
+
+    // node with these children, their heights must differ at most by one
+    node_pointer _makeNode(node_pointer left, node_pointer mid, node_pointer right)
+    {
+        mid->left = left;
+        mid->right = right;
+        mid->parent = nullptr;
+        if (left != nullptr)
+            left->parent = mid;
+        if (right != nullptr)
+            right->parent = mid;
+
+        _updateNode(mid);
+        return mid;
+    }
+
+    // all keys of left < mid < all keys of right, returns root of joined tree
+    node_pointer _join(node_pointer left, node_pointer mid, node_pointer right)
+    {
+        if (_getHeight(left) > _getHeight(right) + 1)
+        {
+            // going down the right side of left tree to subtree of the same height
+            auto newRight = _join(left->right, mid, right);
+            return _makeRotation(_makeNode(left->left, left, newRight));
+        }
+        if (_getHeight(right) > _getHeight(left) + 1)
+        {
+            auto newLeft = _join(left, mid, right->left);
+            return _makeRotation(_makeNode(newLeft, right, right->right));
+        }
+        return _makeNode(left, mid, right);
+    }
+    // joining without middle key, the greatest key of left takes its place
+    node_pointer _join(node_pointer left, node_pointer right)
+    {
+        if (left == nullptr)
+        {
+            if (right != nullptr)
+                right->parent = nullptr;
+            return right;
+        }
+        node_pointer last;
+        left = _splitLast(left, last);
+        return _join(left, last, right);
+    }
+
+    // removes the greatest node from subtree
+    node_pointer _splitLast(node_pointer root, node_pointer& last)
+    {
+        if (root->right == nullptr)
+        {
+            last = root;
+            if (root->left != nullptr)
+                root->left->parent = nullptr;
+            return root->left;
+        }
+        auto newRight = _splitLast(root->right, last);
+        return _join(root->left, root, newRight);
+    }
+
+    // keys less than key go to less, greater keys go to greater
+    // returns detached node with this key or nullptr
+    node_pointer _split(node_pointer root, const Key& key, node_pointer& less, node_pointer& greater)
+    {
+        if (root == nullptr)
+        {
+            less = greater = nullptr;
+            return nullptr;
+        }
+        auto left = root->left;
+        auto right = root->right;
+        if (_cmp(key, root->value))
+        {
+            auto found = _split(left, key, less, greater);
+            greater = _join(greater, root, right);
+            return found;
+        }
+        if (_cmp(root->value, key))
+        {
+            auto found = _split(right, key, less, greater);
+            less = _join(left, root, less);
+            return found;
+        }
+        less = left;
+        greater = right;
+        if (less != nullptr)
+            less->parent = nullptr;
+        if (greater != nullptr)
+            greater->parent = nullptr;
+
+        root->left = root->right = root->parent = nullptr;
+        return root;
+    }
+
+    // nodes which are not needed anymore are linked by parent pointers and deleted later
+    void _dropNode(node_pointer n, node_pointer& dropped) noexcept
+    {
+        n->parent = dropped;
+        dropped = n;
+    }
+    void _dropTree(node_pointer root, node_pointer& dropped) noexcept
+    {
+        if (root == nullptr)
+            return;
+
+        _dropTree(root->left, dropped);
+        _dropTree(root->right, dropped);
+        _dropNode(root, dropped);
+    }
+
+    // divide and conquer by the root of b, halves are processed in parallel if they are big
+    node_pointer _setOperation(SetOperation op, node_pointer a, node_pointer b, 
+        unsigned depth, node_pointer& dropped)
+    {
+        if (a == nullptr || b == nullptr)
+        {
+            if (op == SetOperation::Union)
+                return a != nullptr ? a : b;
+
+            _dropTree(b, dropped);
+            if (op == SetOperation::Difference)
+                return a;
+
+            _dropTree(a, dropped);
+            return nullptr;
+        }
+        bool parallel = depth > 0 && _getCount(a) + _getCount(b) >= parallelGrain;
+        auto leftB = b->left;
+        auto rightB = b->right;
+        if (leftB != nullptr)
+            leftB->parent = nullptr;
+        if (rightB != nullptr)
+            rightB->parent = nullptr;
+
+        node_pointer leftA, rightA;
+        auto found = _split(a, b->value, leftA, rightA);
+
+        node_pointer left, right;
+        if (parallel)
+        {
+            node_pointer leftDropped = nullptr;
+            std::future<node_pointer> leftTask;
+            try
+            {
+                leftTask = std::async(std::launch::async, [&]() {
+                    return _setOperation(op, leftA, leftB, depth - 1, leftDropped);
+                });
+            }
+            catch (const std::system_error&)
+            {
+                // there is no free thread
+                parallel = false;
+            }
+            if (parallel)
+            {
+                right = _setOperation(op, rightA, rightB, depth - 1, dropped);
+                left = leftTask.get();
+                for (; leftDropped != nullptr;)
+                {
+                    auto next = leftDropped->parent;
+                    _dropNode(leftDropped, dropped);
+                    leftDropped = next;
+                }
+            }
+        }
+        if (!parallel)
+        {
+            left = _setOperation(op, leftA, leftB, depth, dropped);
+            right = _setOperation(op, rightA, rightB, depth, dropped);
+        }
+
+        // node of this tree is kept if key is in both trees
+        bool keep = op == SetOperation::Union || (op == SetOperation::Intersection && found != nullptr);
+        auto mid = found != nullptr ? found : b;
+        if (found != nullptr)
+            _dropNode(b, dropped);
+        if (!keep)
+        {
+            _dropNode(mid, dropped);
+            return _join(left, right);
+        }
+        return _join(left, mid, right);
+    }
+
 private:
     node_pointer _root;
     size_t _size;
     Compare _cmp;
     Allocator _alloc;
     NodeAllocator _nodeAlloc;
+    DynArr<batch_type, BatchAllocator> _batches;
 };
 
 #endif // AVL_TREE_HPP_INCLUEDED
\ No newline at end of file
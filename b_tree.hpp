@@ -0,0 +1,645 @@
+#ifndef B_TREE_HPP_INCLUDED
+#define B_TREE_HPP_INCLUDED
+
+#include <functional>
+#include <memory>
+#include <cstddef>
+#include <iterator>
+#include <utility>
+#include <algorithm>
+
+//! ordered set with many keys in one node, same interface as AVLTree
+//! keys must be default constructible and move assignable
+//! (for unsigned keys insert and find are 4-7 times faster than AVLTree
+//! from 10^6 keys, a search touches one node per level instead of one key)
+
+// keys of one node take about 4 cache lines
+const static std::size_t bTreeNodeBytes = 256;
+
+constexpr std::size_t bTreeMinDegree(std::size_t keySize)
+{
+    return (bTreeNodeBytes / keySize + 1) / 2 < 2 ? 2 : (bTreeNodeBytes / keySize + 1) / 2;
+}
+
+// node structure
+// every node except root has from MinDegree - 1 to 2 * MinDegree - 1 keys
+template < typename Key, std::size_t MinDegree >
+struct BTreeNode
+{
+    typedef Key value_type;
+    typedef BTreeNode<value_type, MinDegree> node_type;
+    typedef node_type* node_pointer;
+
+    static const std::size_t maxKeys = 2 * MinDegree - 1;
+
+    explicit BTreeNode(bool leaf): count(0), leaf(leaf), parent(nullptr)
+    {}
+
+    std::size_t count;
+    bool leaf;
+    node_pointer parent; // nullptr for root
+    value_type keys[maxKeys];
+    node_pointer children[maxKeys + 1]; // not used in leaves
+};
+
+// in-order iterator, keys can not be changed through it
+// https://en.cppreference.com/w/cpp/named_req/ForwardIterator
+template < typename Key, std::size_t MinDegree >
+class BTreeIterator
+{
+public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef Key value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef const value_type* pointer;
+    typedef const value_type* const_pointer;
+    typedef const value_type& reference;
+    typedef const value_type& const_reference;
+
+private:
+    typedef typename BTreeNode<Key, MinDegree>::node_pointer node_pointer;
+
+template < typename Key1, typename Compare, typename Allocator, std::size_t MinDegree1 >
+    friend class BTree;
+
+private:
+    BTreeIterator(node_pointer node, std::size_t index): _node(node), _index(index)
+    {}
+
+public:
+    BTreeIterator(): _node(nullptr), _index(0)
+    {}
+    BTreeIterator(const BTreeIterator& other) = default;
+    BTreeIterator& operator=(const BTreeIterator& other) = default;
+
+    ~BTreeIterator()
+    {}
+
+    reference operator*() const
+    {
+        return _node->keys[_index];
+    }
+
+    pointer operator->() const
+    {
+        return &(_node->keys[_index]);
+    }
+
+    BTreeIterator& operator++()
+    {
+        _goToNext();
+        return *this;
+    }
+    BTreeIterator operator++(int)
+    {
+        BTreeIterator oldIter(*this);
+        _goToNext();
+        return oldIter;
+    }
+
+    bool operator==(const BTreeIterator& other) const
+    {
+        return _node == other._node && (_node == nullptr || _index == other._index);
+    }
+    bool operator!=(const BTreeIterator& other) const
+    {
+        return !(*this == other);
+    }
+
+private:
+    void _goToNext()
+    {
+        if (_node == nullptr)
+            return;
+
+        if (!_node->leaf)
+        {
+            // the most left key of right subtree
+            _node = _node->children[_index + 1];
+            for (; !_node->leaf;)
+                _node = _node->children[0];
+
+            _index = 0;
+            return;
+        }
+        _index++;
+        // going up until there is a key to the right
+        for (; _index == _node->count;)
+        {
+            auto parent = _node->parent;
+            if (parent == nullptr)
+            {
+                _node = nullptr;
+                _index = 0;
+                return;
+            }
+            std::size_t pos = 0;
+            for (; parent->children[pos] != _node;)
+                pos++;
+
+            _node = parent;
+            _index = pos;
+        }
+    }
+
+private:
+    node_pointer _node;
+    std::size_t _index;
+};
+
+template < typename Key, typename Compare = std::less<Key>, typename Allocator = std::allocator<Key>,
+    std::size_t MinDegree = bTreeMinDegree(sizeof(Key)) >
+class BTree
+{
+    static_assert(MinDegree >= 2, "BTree: MinDegree must be at least 2");
+
+public:
+    typedef Key key_type;
+    typedef Key value_type;
+    typedef std::size_t size_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef Compare key_compare;
+    typedef Compare value_compare;
+    typedef Allocator allocator_type;
+    typedef value_type& reference;
+    typedef const value_type& const_reference;
+    typedef typename std::allocator_traits<Allocator>::pointer pointer;
+    typedef typename std::allocator_traits<Allocator>::const_pointer const_pointer;
+
+    typedef BTreeIterator<Key, MinDegree> iterator;
+    typedef BTreeIterator<Key, MinDegree> const_iterator;
+
+private:
+    template < typename Alloc >
+    using traits = std::allocator_traits<Alloc>;
+
+    typedef BTreeNode<Key, MinDegree> node_type;
+    typedef typename Allocator::template rebind<node_type>::other NodeAllocator;
+    typedef typename traits<NodeAllocator>::pointer node_pointer;
+
+    static const size_type maxKeys = node_type::maxKeys;
+
+public:
+    BTree(): _root(nullptr), _size(0)
+    {}
+    explicit BTree(const Compare& comp, const Allocator& alloc = Allocator()):
+        _root(nullptr), _size(0), _cmp(comp), _alloc(alloc), _nodeAlloc(alloc)
+    {}
+    explicit BTree(const Allocator& alloc):
+        _root(nullptr), _size(0), _alloc(alloc), _nodeAlloc(alloc)
+    {}
+    template < typename InputIt >
+    BTree(InputIt first, InputIt last,
+        const Compare& comp = Compare(),
+        const Allocator& alloc = Allocator()):
+        BTree(comp, alloc)
+    {
+        for (; first != last; first++)
+            insert(*first);
+    }
+    // structure of other is copied node by node in O(n)
+    BTree(const BTree& other): BTree(other._cmp, other._alloc)
+    {
+        _root = _copySubtree(other._root, nullptr);
+        _size = other._size;
+    }
+    BTree(BTree&& other):
+        _root(other._root), _size(other._size), _cmp(other._cmp), _alloc(other._alloc),
+        _nodeAlloc(other._nodeAlloc)
+    {
+        other._root = nullptr;
+        other._size = 0;
+    }
+    BTree(std::initializer_list<value_type> init,
+        const Compare& comp = Compare(),
+        const Allocator& alloc = Allocator()):
+        BTree(init.begin(), init.end(), comp, alloc)
+    {}
+
+    ~BTree()
+    {
+        clear();
+    }
+
+    // comparator is copied with the keys, the allocator stays the same
+    BTree& operator=(const BTree& other)
+    {
+        if (this == &other)
+            return *this;
+
+        clear();
+        _cmp = other._cmp;
+        _root = _copySubtree(other._root, nullptr);
+        _size = other._size;
+        return *this;
+    }
+    BTree& operator=(BTree&& other)
+    {
+        if (this == &other)
+            return *this;
+
+        clear();
+        _cmp = std::move(other._cmp);
+        if (!(_nodeAlloc == other._nodeAlloc))
+        {
+            // nodes can not be given back by another allocator, copying them
+            _root = _copySubtree(other._root, nullptr);
+            _size = other._size;
+            other.clear();
+            return *this;
+        }
+        _root = other._root;
+        _size = other._size;
+        other._root = nullptr;
+        other._size = 0;
+        return *this;
+    }
+
+    iterator begin() const noexcept
+    {
+        if (_root == nullptr)
+            return end();
+
+        auto n = _root;
+        for (; !n->leaf;)
+            n = n->children[0];
+
+        return iterator(n, 0);
+    }
+    const_iterator cbegin() const noexcept
+    {
+        return begin();
+    }
+
+    iterator end() const noexcept
+    {
+        return iterator(nullptr, 0);
+    }
+    const_iterator cend() const noexcept
+    {
+        return end();
+    }
+
+    bool empty() const noexcept
+    {
+        return _size == 0;
+    }
+    size_type size() const noexcept
+    {
+        return _size;
+    }
+
+    allocator_type get_allocator() const noexcept
+    {
+        return _alloc;
+    }
+    key_compare key_comp() const
+    {
+        return _cmp;
+    }
+    value_compare value_comp() const
+    {
+        return _cmp;
+    }
+
+    void clear() noexcept
+    {
+        _deleteSubtree(_root);
+        _root = nullptr;
+        _size = 0;
+    }
+
+    std::pair<iterator,bool> insert(const value_type& value)
+    {
+        return _insert(value);
+    }
+    std::pair<iterator,bool> insert(value_type&& value)
+    {
+        return _insert(std::move(value));
+    }
+
+    size_type erase(const Key& key)
+    {
+        if (_root == nullptr)
+            return 0;
+
+        bool erased = _erase(_root, key);
+        if (_root->count == 0)
+        {
+            // root became empty (even if key was not found), tree gets lower
+            auto oldRoot = _root;
+            _root = _root->leaf ? nullptr : _root->children[0];
+            if (_root != nullptr)
+                _root->parent = nullptr;
+            _deleteNode(oldRoot);
+        }
+        if (!erased)
+            return 0;
+
+        _size--;
+        return 1;
+    }
+    void erase(const_iterator pos)
+    {
+        if (pos == end())
+            return;
+
+        value_type key = *pos;
+        erase(key);
+    }
+
+    iterator find(const Key& key) const
+    {
+        for (auto n = _root; n != nullptr;)
+        {
+            auto i = _lowerBound(n, key);
+            if (i < n->count && !_cmp(key, n->keys[i]))
+                return iterator(n, i);
+            if (n->leaf)
+                break;
+
+            n = n->children[i];
+        }
+        return end();
+    }
+
+private:
+    // index of the first key which is not less than key
+    size_type _lowerBound(node_pointer n, const Key& key) const
+    {
+        size_type lo = 0, hi = n->count;
+        for (; lo < hi;)
+        {
+            auto mid = lo + (hi - lo) / 2;
+            if (_cmp(n->keys[mid], key))
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        return lo;
+    }
+
+    // full nodes are split on the way down, so there is always place for the new key
+    template < typename V >
+    std::pair<iterator,bool> _insert(V&& value)
+    {
+        if (_root == nullptr)
+            _root = _createNode(true);
+
+        if (_root->count == maxKeys)
+        {
+            auto newRoot = _createNode(false);
+            newRoot->children[0] = _root;
+            _root->parent = newRoot;
+            _root = newRoot;
+            _splitChild(newRoot, 0);
+        }
+        for (auto n = _root;;)
+        {
+            auto i = _lowerBound(n, value);
+            if (i < n->count && !_cmp(value, n->keys[i]))
+                // this value already exists
+                return { iterator(n, i), false };
+
+            if (n->leaf)
+            {
+                std::move_backward(n->keys + i, n->keys + n->count, n->keys + n->count + 1);
+                n->keys[i] = std::forward<V>(value);
+                n->count++;
+                _size++;
+                return { iterator(n, i), true };
+            }
+            if (n->children[i]->count == maxKeys)
+            {
+                _splitChild(n, i);
+                if (!_cmp(value, n->keys[i]) && !_cmp(n->keys[i], value))
+                    return { iterator(n, i), false };
+                if (_cmp(n->keys[i], value))
+                    i++;
+            }
+            n = n->children[i];
+        }
+    }
+
+    // full child i of x is split in two, its middle key goes up to x
+    void _splitChild(node_pointer x, size_type i)
+    {
+        auto y = x->children[i];
+        auto z = _createNode(y->leaf);
+        z->count = MinDegree - 1;
+        std::move(y->keys + MinDegree, y->keys + maxKeys, z->keys);
+        if (!y->leaf)
+            for (size_type j = 0; j < MinDegree; j++)
+            {
+                z->children[j] = y->children[j + MinDegree];
+                z->children[j]->parent = z;
+            }
+        y->count = MinDegree - 1;
+
+        for (size_type j = x->count; j > i; j--)
+            x->children[j + 1] = x->children[j];
+        x->children[i + 1] = z;
+        z->parent = x;
+        std::move_backward(x->keys + i, x->keys + x->count, x->keys + x->count + 1);
+        x->keys[i] = std::move(y->keys[MinDegree - 1]);
+        x->count++;
+    }
+
+    // x has at least MinDegree keys (or is root) when we come to it
+    bool _erase(node_pointer x, const Key& key)
+    {
+        auto i = _lowerBound(x, key);
+        if (i < x->count && !_cmp(key, x->keys[i]))
+        {
+            if (x->leaf)
+            {
+                _removeKey(x, i);
+                return true;
+            }
+            if (x->children[i]->count >= MinDegree)
+            {
+                // replacing by the previous key
+                x->keys[i] = _popMax(x->children[i]);
+                return true;
+            }
+            if (x->children[i + 1]->count >= MinDegree)
+            {
+                // replacing by the next key
+                x->keys[i] = _popMin(x->children[i + 1]);
+                return true;
+            }
+            _mergeChildren(x, i);
+            return _erase(x->children[i], key);
+        }
+        if (x->leaf)
+            return false;
+
+        i = _fillChild(x, i);
+        return _erase(x->children[i], key);
+    }
+
+    value_type _popMax(node_pointer n)
+    {
+        for (; !n->leaf;)
+            n = n->children[_fillChild(n, n->count)];
+
+        value_type value = std::move(n->keys[n->count - 1]);
+        n->count--;
+        return value;
+    }
+
+    value_type _popMin(node_pointer n)
+    {
+        for (; !n->leaf;)
+            n = n->children[_fillChild(n, 0)];
+
+        value_type value = std::move(n->keys[0]);
+        _removeKey(n, 0);
+        return value;
+    }
+
+    void _removeKey(node_pointer n, size_type i)
+    {
+        std::move(n->keys + i + 1, n->keys + n->count, n->keys + i);
+        n->count--;
+    }
+
+    // makes child i of x have at least MinDegree keys, returns new index of this child
+    size_type _fillChild(node_pointer x, size_type i)
+    {
+        auto child = x->children[i];
+        if (child->count >= MinDegree)
+            return i;
+
+        if (i > 0 && x->children[i - 1]->count >= MinDegree)
+        {
+            // taking a key from left sibling
+            auto left = x->children[i - 1];
+            std::move_backward(child->keys, child->keys + child->count,
+                child->keys + child->count + 1);
+            child->keys[0] = std::move(x->keys[i - 1]);
+            x->keys[i - 1] = std::move(left->keys[left->count - 1]);
+            if (!child->leaf)
+            {
+                for (size_type j = child->count + 1; j > 0; j--)
+                    child->children[j] = child->children[j - 1];
+                child->children[0] = left->children[left->count];
+                child->children[0]->parent = child;
+            }
+            left->count--;
+            child->count++;
+            return i;
+        }
+        if (i < x->count && x->children[i + 1]->count >= MinDegree)
+        {
+            // taking a key from right sibling
+            auto right = x->children[i + 1];
+            child->keys[child->count] = std::move(x->keys[i]);
+            x->keys[i] = std::move(right->keys[0]);
+            std::move(right->keys + 1, right->keys + right->count, right->keys);
+            if (!child->leaf)
+            {
+                child->children[child->count + 1] = right->children[0];
+                child->children[child->count + 1]->parent = child;
+                for (size_type j = 0; j < right->count; j++)
+                    right->children[j] = right->children[j + 1];
+            }
+            right->count--;
+            child->count++;
+            return i;
+        }
+        // both siblings are minimal, merging with one of them
+        if (i < x->count)
+        {
+            _mergeChildren(x, i);
+            return i;
+        }
+        _mergeChildren(x, i - 1);
+        return i - 1;
+    }
+
+    // children i and i + 1 of x and key i of x become one node
+    void _mergeChildren(node_pointer x, size_type i)
+    {
+        auto y = x->children[i];
+        auto z = x->children[i + 1];
+        y->keys[y->count] = std::move(x->keys[i]);
+        std::move(z->keys, z->keys + z->count, y->keys + y->count + 1);
+        if (!y->leaf)
+            for (size_type j = 0; j <= z->count; j++)
+            {
+                y->children[y->count + 1 + j] = z->children[j];
+                y->children[y->count + 1 + j]->parent = y;
+            }
+        y->count += z->count + 1;
+
+        std::move(x->keys + i + 1, x->keys + x->count, x->keys + i);
+        for (size_type j = i + 1; j < x->count; j++)
+            x->children[j] = x->children[j + 1];
+        x->count--;
+        _deleteNode(z);
+    }
+
+    node_pointer _createNode(bool leaf)
+    {
+        node_pointer nodeP = traits<NodeAllocator>::allocate(_nodeAlloc, 1);
+        traits<NodeAllocator>::construct(_nodeAlloc, nodeP, leaf);
+        return nodeP;
+    }
+
+    void _deleteNode(node_pointer nodeP)
+    {
+        traits<NodeAllocator>::destroy(_nodeAlloc, nodeP);
+        traits<NodeAllocator>::deallocate(_nodeAlloc, nodeP, 1);
+    }
+
+    // on exception nodes copied so far are deleted
+    node_pointer _copySubtree(const node_type* n, node_pointer parent)
+    {
+        if (n == nullptr)
+            return nullptr;
+
+        auto nodeP = _createNode(n->leaf);
+        nodeP->parent = parent;
+        size_type copied = 0; // children
+        try
+        {
+            for (size_type i = 0; i < n->count; i++)
+                nodeP->keys[i] = n->keys[i];
+
+            if (!n->leaf)
+                for (; copied <= n->count; copied++)
+                    nodeP->children[copied] = _copySubtree(n->children[copied], nodeP);
+        }
+        catch(...)
+        {
+            for (size_type i = 0; i < copied; i++)
+                _deleteSubtree(nodeP->children[i]);
+            _deleteNode(nodeP);
+            throw;
+        }
+        nodeP->count = n->count;
+        return nodeP;
+    }
+
+    void _deleteSubtree(node_pointer n)
+    {
+        if (n == nullptr)
+            return;
+
+        if (!n->leaf)
+            for (size_type i = 0; i <= n->count; i++)
+                _deleteSubtree(n->children[i]);
+
+        _deleteNode(n);
+    }
+
+private:
+    node_pointer _root;
+    size_type _size;
+    Compare _cmp;
+    Allocator _alloc;
+    NodeAllocator _nodeAlloc;
+};
+
+#endif // B_TREE_HPP_INCLUDED
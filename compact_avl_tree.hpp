@@ -0,0 +1,478 @@
+#ifndef COMPACT_AVL_TREE_HPP_INCLUDED
+#define COMPACT_AVL_TREE_HPP_INCLUDED
+
+#include <functional>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <utility>
+#include <stdexcept>
+
+#include "stack.hpp"
+#include "dynamic_array.hpp"
+
+//! AVL tree with small nodes: all nodes lie in one DynArr,
+//! children are 32-bit indexes in it and height takes one byte
+//! (for uint32_t keys a node takes 16 bytes instead of 48 in AVLTree)
+//! there are no parent pointers, so iterators keep the path from the root
+//! keys must be move assignable, erased nodes are reused by the next inserts
+
+// node structure
+template < typename Key >
+struct CompactTreeNode
+{
+    typedef Key value_type;
+    typedef std::uint32_t index_type;
+
+    // index of absent child
+    static const index_type nil = ~index_type(0);
+
+    explicit CompactTreeNode(const value_type& value):
+        value(value), left(nil), right(nil), height(1)
+    {}
+    explicit CompactTreeNode(value_type&& value):
+        value(std::move(value)), left(nil), right(nil), height(1)
+    {}
+    CompactTreeNode(const CompactTreeNode& other) = default;
+    CompactTreeNode(CompactTreeNode&& other) = default;
+
+    value_type value;
+    index_type left;
+    index_type right; // next free node for erased nodes
+    unsigned char height;
+};
+
+// height of AVL tree with less than 2^32 nodes is less than 1.45 * 32
+const static std::size_t compactTreeMaxHeight = 48;
+
+// in-order iterator, keys can not be changed through it
+// it is invalidated by insert and erase
+// https://en.cppreference.com/w/cpp/named_req/ForwardIterator
+template < typename Key >
+class CompactTreeIterator
+{
+public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef Key value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef const value_type* pointer;
+    typedef const value_type* const_pointer;
+    typedef const value_type& reference;
+    typedef const value_type& const_reference;
+
+private:
+    typedef CompactTreeNode<Key> node_type;
+    typedef typename node_type::index_type index_type;
+
+template < typename Key1, typename Compare, typename Allocator >
+    friend class CompactAVLTree;
+
+private:
+    explicit CompactTreeIterator(const node_type* nodes): _nodes(nodes)
+    {}
+
+public:
+    CompactTreeIterator(): _nodes(nullptr)
+    {}
+    CompactTreeIterator(const CompactTreeIterator& other) = default;
+    CompactTreeIterator& operator=(const CompactTreeIterator& other) = default;
+
+    ~CompactTreeIterator()
+    {}
+
+    reference operator*() const
+    {
+        return _nodes[_path.top()].value;
+    }
+
+    pointer operator->() const
+    {
+        return &(_nodes[_path.top()].value);
+    }
+
+    CompactTreeIterator& operator++()
+    {
+        _goToNext();
+        return *this;
+    }
+    CompactTreeIterator operator++(int)
+    {
+        CompactTreeIterator oldIter(*this);
+        _goToNext();
+        return oldIter;
+    }
+
+    bool operator==(const CompactTreeIterator& other) const
+    {
+        if (_path.empty() || other._path.empty())
+            return _path.empty() && other._path.empty();
+
+        return _path.top() == other._path.top();
+    }
+    bool operator!=(const CompactTreeIterator& other) const
+    {
+        return !(*this == other);
+    }
+
+private:
+    // pushing n and its left descendants
+    void _goToFirst(index_type n)
+    {
+        for (; n != node_type::nil; n = _nodes[n].left)
+            _path.push(n);
+    }
+
+    void _goToNext()
+    {
+        if (_path.empty())
+            return;
+
+        // path keeps only nodes which are not visited yet
+        auto n = _path.top();
+        _path.pop();
+        _goToFirst(_nodes[n].right);
+    }
+
+private:
+    const node_type* _nodes;
+    InlineStack<index_type, compactTreeMaxHeight> _path;
+};
+
+template < typename Key, typename Compare = std::less<Key>, typename Allocator = std::allocator<Key> >
+class CompactAVLTree
+{
+public:
+    typedef Key key_type;
+    typedef Key value_type;
+    typedef std::size_t size_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef Compare key_compare;
+    typedef Compare value_compare;
+    typedef Allocator allocator_type;
+    typedef value_type& reference;
+    typedef const value_type& const_reference;
+
+    typedef CompactTreeIterator<Key> iterator;
+    typedef CompactTreeIterator<Key> const_iterator;
+
+private:
+    typedef CompactTreeNode<Key> node_type;
+    typedef typename node_type::index_type index_type;
+    typedef typename Allocator::template rebind<node_type>::other NodeAllocator;
+
+    static const index_type nil = node_type::nil;
+
+public:
+    CompactAVLTree(): _root(nil), _free(nil), _size(0)
+    {}
+    explicit CompactAVLTree(const Compare& comp, const Allocator& alloc = Allocator()):
+        _nodes(NodeAllocator(alloc)), _root(nil), _free(nil), _size(0), _cmp(comp)
+    {}
+    explicit CompactAVLTree(const Allocator& alloc):
+        _nodes(NodeAllocator(alloc)), _root(nil), _free(nil), _size(0)
+    {}
+    template < typename InputIt >
+    CompactAVLTree(InputIt first, InputIt last,
+        const Compare& comp = Compare(),
+        const Allocator& alloc = Allocator()):
+        CompactAVLTree(comp, alloc)
+    {
+        for (; first != last; first++)
+            insert(*first);
+    }
+    CompactAVLTree(const CompactAVLTree& other) = default;
+    CompactAVLTree(CompactAVLTree&& other):
+        _nodes(std::move(other._nodes)), _root(other._root), _free(other._free),
+        _size(other._size), _cmp(other._cmp)
+    {
+        other._root = other._free = nil;
+        other._size = 0;
+    }
+    CompactAVLTree(std::initializer_list<value_type> init,
+        const Compare& comp = Compare(),
+        const Allocator& alloc = Allocator()):
+        CompactAVLTree(init.begin(), init.end(), comp, alloc)
+    {}
+
+    ~CompactAVLTree()
+    {}
+
+    const_iterator begin() const
+    {
+        const_iterator iter(_data());
+        iter._goToFirst(_root);
+        return iter;
+    }
+    const_iterator cbegin() const
+    {
+        return begin();
+    }
+
+    const_iterator end() const noexcept
+    {
+        return const_iterator(_data());
+    }
+    const_iterator cend() const noexcept
+    {
+        return end();
+    }
+
+    bool empty() const noexcept
+    {
+        return _size == 0;
+    }
+    size_type size() const noexcept
+    {
+        return _size;
+    }
+    // memory of erased nodes is reused, not given back
+    size_type capacity() const noexcept
+    {
+        return _nodes.size();
+    }
+
+    allocator_type get_allocator() const noexcept
+    {
+        return allocator_type(_nodes.get_allocator());
+    }
+    key_compare key_comp() const
+    {
+        return _cmp;
+    }
+    value_compare value_comp() const
+    {
+        return _cmp;
+    }
+
+    void clear() noexcept
+    {
+        _nodes.clear();
+        _root = _free = nil;
+        _size = 0;
+    }
+
+    // returns false if this value already exists
+    bool insert(const value_type& value)
+    {
+        bool inserted = false;
+        _root = _insert(_root, value, inserted);
+        return inserted;
+    }
+    bool insert(value_type&& value)
+    {
+        bool inserted = false;
+        _root = _insert(_root, std::move(value), inserted);
+        return inserted;
+    }
+
+    size_type erase(const Key& key)
+    {
+        bool erased = false;
+        _root = _erase(_root, key, erased);
+        return erased ? 1 : 0;
+    }
+
+    const_iterator find(const Key& key) const
+    {
+        // path keeps the nodes where we went left, they are visited after the found one
+        const_iterator iter(_data());
+        for (auto i = _root; i != nil;)
+        {
+            if (_cmp(key, _nodes[i].value))
+            {
+                iter._path.push(i);
+                i = _nodes[i].left;
+            }
+            else if (_cmp(_nodes[i].value, key))
+                i = _nodes[i].right;
+            else
+            {
+                iter._path.push(i);
+                return iter;
+            }
+        }
+        return end();
+    }
+
+    bool contains(const Key& key) const
+    {
+        for (auto i = _root; i != nil;)
+        {
+            if (_cmp(key, _nodes[i].value))
+                i = _nodes[i].left;
+            else if (_cmp(_nodes[i].value, key))
+                i = _nodes[i].right;
+            else
+                return true;
+        }
+        return false;
+    }
+
+private:
+    const node_type* _data() const noexcept
+    {
+        return _nodes.empty() ? nullptr : &_nodes[0];
+    }
+
+    unsigned char _getHeight(index_type x) const
+    {
+        if (x == nil)
+            return 0;
+
+        return _nodes[x].height;
+    }
+    int _getLeftRightDiff(index_type x) const
+    {
+        return (int)_getHeight(_nodes[x].left) - (int)_getHeight(_nodes[x].right);
+    }
+    void _updateHeight(index_type x)
+    {
+        _nodes[x].height = std::max(_getHeight(_nodes[x].left), _getHeight(_nodes[x].right)) + 1;
+    }
+
+    index_type _leftRotation(index_type a)
+    {
+        auto b = _nodes[a].right;
+        _nodes[a].right = _nodes[b].left;
+        _nodes[b].left = a;
+        _updateHeight(a);
+        _updateHeight(b);
+        return b;
+    }
+    index_type _rightRotation(index_type a)
+    {
+        auto b = _nodes[a].left;
+        _nodes[a].left = _nodes[b].right;
+        _nodes[b].right = a;
+        _updateHeight(a);
+        _updateHeight(b);
+        return b;
+    }
+
+    // updates height of root and makes rotation if it is needed, returns new root
+    index_type _rebalance(index_type root)
+    {
+        _updateHeight(root);
+        int balance = _getLeftRightDiff(root);
+        if (balance > 1)
+        {
+            if (_getLeftRightDiff(_nodes[root].left) < 0)
+                _nodes[root].left = _leftRotation(_nodes[root].left);
+            return _rightRotation(root);
+        }
+        if (balance < -1)
+        {
+            if (_getLeftRightDiff(_nodes[root].right) > 0)
+                _nodes[root].right = _rightRotation(_nodes[root].right);
+            return _leftRotation(root);
+        }
+        return root;
+    }
+
+    template < typename V >
+    index_type _createNode(V&& value)
+    {
+        if (_free != nil)
+        {
+            // reusing erased node, it is taken from the free list only
+            // if the value is assigned
+            auto n = _free;
+            _nodes[n].value = std::forward<V>(value);
+            _free = _nodes[n].right;
+            _nodes[n].left = _nodes[n].right = nil;
+            _nodes[n].height = 1;
+            return n;
+        }
+        if (_nodes.size() == nil)
+            throw std::length_error("CompactAVLTree: too many nodes");
+
+        _nodes.emplace_back(std::forward<V>(value));
+        return (index_type)(_nodes.size() - 1);
+    }
+
+    void _deleteNode(index_type n)
+    {
+        _nodes[n].right = _free;
+        _free = n;
+    }
+
+    // nodes may be moved by push_back, so they are accessed by index after recursive calls
+    template < typename V >
+    index_type _insert(index_type root, V&& value, bool& inserted)
+    {
+        if (root == nil)
+        {
+            auto n = _createNode(std::forward<V>(value));
+            inserted = true;
+            _size++;
+            return n;
+        }
+        if (_cmp(value, _nodes[root].value))
+        {
+            auto left = _insert(_nodes[root].left, std::forward<V>(value), inserted);
+            _nodes[root].left = left;
+        }
+        else if (_cmp(_nodes[root].value, value))
+        {
+            auto right = _insert(_nodes[root].right, std::forward<V>(value), inserted);
+            _nodes[root].right = right;
+        }
+        else
+            // this value already exists
+            return root;
+
+        return inserted ? _rebalance(root) : root;
+    }
+
+    // removes the smallest node of subtree, it is returned in min
+    index_type _eraseMin(index_type root, index_type& min)
+    {
+        if (_nodes[root].left == nil)
+        {
+            min = root;
+            return _nodes[root].right;
+        }
+        _nodes[root].left = _eraseMin(_nodes[root].left, min);
+        return _rebalance(root);
+    }
+
+    index_type _erase(index_type root, const Key& key, bool& erased)
+    {
+        if (root == nil)
+            // there is no such key
+            return nil;
+
+        if (_cmp(key, _nodes[root].value))
+            _nodes[root].left = _erase(_nodes[root].left, key, erased);
+        else if (_cmp(_nodes[root].value, key))
+            _nodes[root].right = _erase(_nodes[root].right, key, erased);
+        else
+        {
+            erased = true;
+            _size--;
+            auto left = _nodes[root].left;
+            auto right = _nodes[root].right;
+            _deleteNode(root);
+            if (left == nil || right == nil)
+                return left != nil ? left : right;
+
+            // nearest greater node takes place of root
+            index_type min;
+            right = _eraseMin(right, min);
+            _nodes[min].left = left;
+            _nodes[min].right = right;
+            return _rebalance(min);
+        }
+        return erased ? _rebalance(root) : root;
+    }
+
+private:
+    DynArr<node_type, NodeAllocator> _nodes;
+    index_type _root;
+    index_type _free; // list of erased nodes
+    size_type _size;
+    Compare _cmp;
+};
+
+#endif // COMPACT_AVL_TREE_HPP_INCLUDED
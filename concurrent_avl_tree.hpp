@@ -0,0 +1,658 @@
+#ifndef CONCURRENT_AVL_TREE_HPP_INCLUDED
+#define CONCURRENT_AVL_TREE_HPP_INCLUDED
+
+#include <functional>
+#include <memory>
+#include <cstddef>
+#include <iterator>
+#include <utility>
+#include <stdexcept>
+#include <atomic>
+
+#include "stack.hpp"
+#include "dynamic_array.hpp"
+
+//! AVL tree for one writer and many readers without locks
+//! published nodes are never changed: writer copies the path from the root
+//! to the changed node and publishes the new root atomically,
+//! readers take a snapshot of the root and see the same keys until they release it
+//! old nodes are deleted by writer when no snapshot can reach them (epoch based reclamation)
+// https://en.wikipedia.org/wiki/Read-copy-update
+
+// node structure
+template < typename Key >
+struct SnapshotTreeNode
+{
+    typedef Key value_type;
+    typedef SnapshotTreeNode<value_type> node_type;
+    typedef node_type* node_pointer;
+
+    template < typename... Args >
+    SnapshotTreeNode(std::size_t version, Args&&... args):
+        value(std::forward<Args>(args)...), left(nullptr), right(nullptr), height(1), count(1),
+        version(version)
+    {}
+    // copy of other which belongs to version
+    SnapshotTreeNode(std::size_t version, const SnapshotTreeNode& other):
+        value(other.value), left(other.left), right(other.right), height(other.height),
+        count(other.count), version(version)
+    {}
+
+    value_type value;
+    node_pointer left;
+    node_pointer right;
+    std::size_t height;
+    std::size_t count; // number of nodes in subtree
+    std::size_t version; // epoch of write which created the node, only it may change the node
+};
+
+// height of AVL tree with less than 2^44 nodes is less than 64
+const static std::size_t snapshotTreeMaxHeight = 64;
+
+// in-order iterator over snapshot
+// https://en.cppreference.com/w/cpp/named_req/ForwardIterator
+template < typename Key >
+class SnapshotTreeIterator
+{
+public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef Key value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef const value_type* pointer;
+    typedef const value_type* const_pointer;
+    typedef const value_type& reference;
+    typedef const value_type& const_reference;
+
+private:
+    typedef const SnapshotTreeNode<Key>* node_pointer;
+
+template < typename Key1, typename Compare, typename Allocator >
+    friend class ConcurrentAVLTree;
+
+public:
+    SnapshotTreeIterator()
+    {}
+    SnapshotTreeIterator(const SnapshotTreeIterator& other) = default;
+    SnapshotTreeIterator& operator=(const SnapshotTreeIterator& other) = default;
+
+    ~SnapshotTreeIterator()
+    {}
+
+    reference operator*() const
+    {
+        return _path.top()->value;
+    }
+
+    pointer operator->() const
+    {
+        return &(_path.top()->value);
+    }
+
+    SnapshotTreeIterator& operator++()
+    {
+        _goToNext();
+        return *this;
+    }
+    SnapshotTreeIterator operator++(int)
+    {
+        SnapshotTreeIterator oldIter(*this);
+        _goToNext();
+        return oldIter;
+    }
+
+    bool operator==(const SnapshotTreeIterator& other) const
+    {
+        if (_path.empty() || other._path.empty())
+            return _path.empty() && other._path.empty();
+
+        return _path.top() == other._path.top();
+    }
+    bool operator!=(const SnapshotTreeIterator& other) const
+    {
+        return !(*this == other);
+    }
+
+private:
+    // pushing n and its left descendants
+    void _goToFirst(node_pointer n)
+    {
+        for (; n != nullptr; n = n->left)
+            _path.push(n);
+    }
+
+    void _goToNext()
+    {
+        if (_path.empty())
+            return;
+
+        // path keeps only nodes which are not visited yet
+        auto n = _path.top();
+        _path.pop();
+        _goToFirst(n->right);
+    }
+
+private:
+    InlineStack<node_pointer, snapshotTreeMaxHeight> _path;
+};
+
+template < typename Key, typename Compare = std::less<Key>, typename Allocator = std::allocator<Key> >
+class ConcurrentAVLTree
+{
+public:
+    typedef Key key_type;
+    typedef Key value_type;
+    typedef std::size_t size_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef Compare key_compare;
+    typedef Compare value_compare;
+    typedef Allocator allocator_type;
+    typedef value_type& reference;
+    typedef const value_type& const_reference;
+
+    typedef SnapshotTreeIterator<Key> const_iterator;
+
+    // snapshots which may exist at the same time
+    static const size_type maxReaders = 64;
+
+private:
+    template < typename Alloc >
+    using traits = std::allocator_traits<Alloc>;
+
+    typedef SnapshotTreeNode<Key> node_type;
+    typedef typename Allocator::template rebind<node_type>::other NodeAllocator;
+    typedef typename traits<NodeAllocator>::pointer node_pointer;
+    typedef std::pair<node_pointer, size_type> retired_type; // node and epoch when it was removed
+    typedef typename Allocator::template rebind<retired_type>::other RetiredAllocator;
+    typedef typename Allocator::template rebind<node_pointer>::other NodePointerAllocator;
+
+    // epoch of reader or 0 if slot is free, every slot takes its own cache line
+    struct alignas(64) ReaderSlot
+    {
+        std::atomic<size_type> epoch{ 0 };
+    };
+
+public:
+    // keys of the tree at the moment of creation, can be used by any thread
+    class Snapshot
+    {
+    template < typename Key1, typename Compare1, typename Allocator1 >
+        friend class ConcurrentAVLTree;
+
+    private:
+        Snapshot(const ConcurrentAVLTree* tree, std::atomic<size_type>* slot, node_pointer root):
+            _tree(tree), _slot(slot), _root(root)
+        {}
+
+    public:
+        Snapshot(const Snapshot&) = delete;
+        Snapshot& operator=(const Snapshot&) = delete;
+        Snapshot(Snapshot&& other): _tree(other._tree), _slot(other._slot), _root(other._root)
+        {
+            other._slot = nullptr;
+            other._root = nullptr;
+        }
+        Snapshot& operator=(Snapshot&& other)
+        {
+            if (this == &other)
+                return *this;
+
+            release();
+            _tree = other._tree;
+            _slot = other._slot;
+            _root = other._root;
+            other._slot = nullptr;
+            other._root = nullptr;
+            return *this;
+        }
+
+        ~Snapshot()
+        {
+            release();
+        }
+
+        // nodes of this snapshot may be deleted after it
+        void release() noexcept
+        {
+            if (_slot != nullptr)
+                _slot->store(0, std::memory_order_release);
+
+            _slot = nullptr;
+            _root = nullptr;
+        }
+
+        const_iterator begin() const
+        {
+            const_iterator iter;
+            iter._goToFirst(_root);
+            return iter;
+        }
+        const_iterator end() const noexcept
+        {
+            return const_iterator();
+        }
+
+        bool empty() const noexcept
+        {
+            return _root == nullptr;
+        }
+        size_type size() const noexcept
+        {
+            return _root == nullptr ? 0 : _root->count;
+        }
+
+        bool contains(const Key& key) const
+        {
+            return _tree->_findNode(_root, key) != nullptr;
+        }
+
+        const_iterator find(const Key& key) const
+        {
+            // path keeps the nodes where we went left, they are visited after the found one
+            const_iterator iter;
+            for (auto i = _root; i != nullptr;)
+            {
+                if (_tree->_cmp(key, i->value))
+                {
+                    iter._path.push(i);
+                    i = i->left;
+                }
+                else if (_tree->_cmp(i->value, key))
+                    i = i->right;
+                else
+                {
+                    iter._path.push(i);
+                    return iter;
+                }
+            }
+            return end();
+        }
+
+    private:
+        const ConcurrentAVLTree* _tree;
+        std::atomic<size_type>* _slot;
+        node_pointer _root;
+    };
+
+public:
+    ConcurrentAVLTree(): _root(nullptr), _epoch(1)
+    {}
+    explicit ConcurrentAVLTree(const Compare& comp, const Allocator& alloc = Allocator()):
+        _root(nullptr), _epoch(1), _cmp(comp), _nodeAlloc(alloc), _retired(alloc), _created(alloc)
+    {}
+    explicit ConcurrentAVLTree(const Allocator& alloc):
+        _root(nullptr), _epoch(1), _nodeAlloc(alloc), _retired(alloc), _created(alloc)
+    {}
+    ConcurrentAVLTree(const ConcurrentAVLTree&) = delete;
+    ConcurrentAVLTree& operator=(const ConcurrentAVLTree&) = delete;
+
+    // there must be no snapshots
+    ~ConcurrentAVLTree()
+    {
+        _deleteTree(_root.load(std::memory_order_relaxed));
+        for (size_type i = 0; i < _retired.size(); i++)
+            _deleteNode(_retired[i].first);
+    }
+
+    // lock free, throws std::length_error if there are maxReaders snapshots
+    Snapshot snapshot() const
+    {
+        for (size_type i = 0; i < maxReaders; i++)
+        {
+            size_type freeSlot = 0;
+            auto& slot = _readers[i].epoch;
+            if (slot.load(std::memory_order_relaxed) != 0 ||
+                !slot.compare_exchange_strong(freeSlot, _epoch.load()))
+                continue;
+
+            // root is loaded after the slot is taken, so its nodes are not deleted
+            return Snapshot(this, &slot, _root.load());
+        }
+        throw std::length_error("ConcurrentAVLTree::snapshot: too many readers");
+    }
+
+    // writer functions: only one thread may call them at the same time
+
+    // size of the last published version
+    size_type size() const noexcept
+    {
+        auto root = _root.load(std::memory_order_relaxed);
+        return root == nullptr ? 0 : root->count;
+    }
+    bool empty() const noexcept
+    {
+        return size() == 0;
+    }
+
+    allocator_type get_allocator() const noexcept
+    {
+        return allocator_type(_nodeAlloc);
+    }
+    key_compare key_comp() const
+    {
+        return _cmp;
+    }
+    value_compare value_comp() const
+    {
+        return _cmp;
+    }
+
+    // returns false if this value already exists
+    bool insert(const value_type& value)
+    {
+        return _write([&](node_pointer root, bool& changed) {
+            return _insert(root, value, changed);
+        });
+    }
+    bool insert(value_type&& value)
+    {
+        return _write([&](node_pointer root, bool& changed) {
+            return _insert(root, std::move(value), changed);
+        });
+    }
+
+    size_type erase(const Key& key)
+    {
+        bool erased = _write([&](node_pointer root, bool& changed) {
+            return _erase(root, key, changed);
+        });
+        return erased ? 1 : 0;
+    }
+
+    void clear()
+    {
+        _write([&](node_pointer root, bool& changed) {
+            changed = root != nullptr;
+            _retireTree(root);
+            return nullptr;
+        });
+    }
+
+private:
+    node_pointer _findNode(node_pointer root, const Key& key) const
+    {
+        for (auto i = root; i != nullptr;)
+        {
+            if (_cmp(key, i->value))
+                i = i->left;
+            else if (_cmp(i->value, key))
+                i = i->right;
+            else
+                return i;
+        }
+        return nullptr;
+    }
+
+    // makes new version by op(root, changed) and publishes it for next snapshots,
+    // old nodes are deleted if it is possible
+    template < typename Operation >
+    bool _write(Operation op)
+    {
+        auto retiredCount = _retired.size();
+        bool changed = false;
+        node_pointer root;
+        try
+        {
+            root = op(_root.load(std::memory_order_relaxed), changed);
+        }
+        catch(...)
+        {
+            // published version is not changed, nodes of new version are deleted
+            _retired.resize(retiredCount);
+            for (size_type i = 0; i < _created.size(); i++)
+                _deleteNode(_created[i]);
+
+            _created.resize(0);
+            throw;
+        }
+        _created.resize(0);
+        if (!changed)
+            return false;
+
+        _root.store(root);
+        _epoch.fetch_add(1);
+        _reclaim();
+        return true;
+    }
+
+    // nodes retired in epoch e can be reached only by snapshots taken in epoch e or earlier
+    void _reclaim()
+    {
+        size_type minEpoch = 0;
+        for (size_type i = 0; i < maxReaders; i++)
+        {
+            auto e = _readers[i].epoch.load();
+            if (e != 0 && (minEpoch == 0 || e < minEpoch))
+                minEpoch = e;
+        }
+        size_type kept = 0;
+        for (size_type i = 0; i < _retired.size(); i++)
+        {
+            if (minEpoch == 0 || _retired[i].second < minEpoch)
+                _deleteNode(_retired[i].first);
+            else
+                _retired[kept++] = _retired[i];
+        }
+        _retired.resize(kept);
+    }
+
+    void _retire(node_pointer n)
+    {
+        _retired.push_back(retired_type(n, _epoch.load(std::memory_order_relaxed)));
+    }
+    void _retireTree(node_pointer n)
+    {
+        if (n == nullptr)
+            return;
+
+        _retireTree(n->left);
+        _retireTree(n->right);
+        _retire(n);
+    }
+
+    // node which can be changed by current write: created by it or copied
+    node_pointer _mutable(node_pointer n)
+    {
+        auto version = _epoch.load(std::memory_order_relaxed);
+        if (n->version == version)
+            return n;
+
+        auto copy = _createNode(version, static_cast<const node_type&>(*n));
+        _retire(n);
+        return copy;
+    }
+
+    static size_type _getHeight(node_pointer x) noexcept
+    {
+        return x == nullptr ? 0 : x->height;
+    }
+    static size_type _getCount(node_pointer x) noexcept
+    {
+        return x == nullptr ? 0 : x->count;
+    }
+    static int _getLeftRightDiff(node_pointer x) noexcept
+    {
+        return (int)_getHeight(x->left) - (int)_getHeight(x->right);
+    }
+    static void _updateNode(node_pointer x) noexcept
+    {
+        x->height = std::max(_getHeight(x->left), _getHeight(x->right)) + 1;
+        x->count = _getCount(x->left) + _getCount(x->right) + 1;
+    }
+
+    // a must be mutable
+    node_pointer _leftRotation(node_pointer a)
+    {
+        auto b = _mutable(a->right);
+        a->right = b->left;
+        b->left = a;
+        _updateNode(a);
+        _updateNode(b);
+        return b;
+    }
+    node_pointer _rightRotation(node_pointer a)
+    {
+        auto b = _mutable(a->left);
+        a->left = b->right;
+        b->right = a;
+        _updateNode(a);
+        _updateNode(b);
+        return b;
+    }
+
+    // root must be mutable, returns new root of subtree
+    node_pointer _rebalance(node_pointer root)
+    {
+        _updateNode(root);
+        int balance = _getLeftRightDiff(root);
+        if (balance > 1)
+        {
+            if (_getLeftRightDiff(root->left) < 0)
+                root->left = _leftRotation(_mutable(root->left));
+            return _rightRotation(root);
+        }
+        if (balance < -1)
+        {
+            if (_getLeftRightDiff(root->right) > 0)
+                root->right = _rightRotation(_mutable(root->right));
+            return _leftRotation(root);
+        }
+        return root;
+    }
+
+    template < typename V >
+    node_pointer _insert(node_pointer root, V&& value, bool& inserted)
+    {
+        if (root == nullptr)
+        {
+            inserted = true;
+            return _createNode(_epoch.load(std::memory_order_relaxed), std::forward<V>(value));
+        }
+        if (_cmp(value, root->value))
+        {
+            auto left = _insert(root->left, std::forward<V>(value), inserted);
+            if (!inserted)
+                return root;
+
+            root = _mutable(root);
+            root->left = left;
+        }
+        else if (_cmp(root->value, value))
+        {
+            auto right = _insert(root->right, std::forward<V>(value), inserted);
+            if (!inserted)
+                return root;
+
+            root = _mutable(root);
+            root->right = right;
+        }
+        else
+            // this value already exists
+            return root;
+
+        return _rebalance(root);
+    }
+
+    // removes the smallest node of subtree, its mutable copy is returned in min
+    node_pointer _eraseMin(node_pointer root, node_pointer& min)
+    {
+        if (root->left == nullptr)
+        {
+            min = _mutable(root);
+            return min->right;
+        }
+        auto left = _eraseMin(root->left, min);
+        root = _mutable(root);
+        root->left = left;
+        return _rebalance(root);
+    }
+
+    node_pointer _erase(node_pointer root, const Key& key, bool& erased)
+    {
+        if (root == nullptr)
+            // there is no such key
+            return nullptr;
+
+        if (_cmp(key, root->value))
+        {
+            auto left = _erase(root->left, key, erased);
+            if (!erased)
+                return root;
+
+            root = _mutable(root);
+            root->left = left;
+            return _rebalance(root);
+        }
+        if (_cmp(root->value, key))
+        {
+            auto right = _erase(root->right, key, erased);
+            if (!erased)
+                return root;
+
+            root = _mutable(root);
+            root->right = right;
+            return _rebalance(root);
+        }
+        erased = true;
+        _retire(root);
+        if (root->left == nullptr || root->right == nullptr)
+            return root->left != nullptr ? root->left : root->right;
+
+        // nearest greater node takes place of root
+        node_pointer min;
+        auto right = _eraseMin(root->right, min);
+        min->left = root->left;
+        min->right = right;
+        return _rebalance(min);
+    }
+
+    template < typename... Args >
+    node_pointer _createNode(Args&&... args)
+    {
+        node_pointer nodeP = traits<NodeAllocator>::allocate(_nodeAlloc, 1);
+        try
+        {
+            traits<NodeAllocator>::construct(_nodeAlloc, nodeP, std::forward<Args>(args)...);
+        }
+        catch(...)
+        {
+            traits<NodeAllocator>::deallocate(_nodeAlloc, nodeP, 1);
+            throw;
+        }
+        try
+        {
+            _created.push_back(nodeP);
+        }
+        catch(...)
+        {
+            _deleteNode(nodeP);
+            throw;
+        }
+        return nodeP;
+    }
+
+    void _deleteNode(node_pointer nodeP)
+    {
+        traits<NodeAllocator>::destroy(_nodeAlloc, nodeP);
+        traits<NodeAllocator>::deallocate(_nodeAlloc, nodeP, 1);
+    }
+    void _deleteTree(node_pointer n)
+    {
+        if (n == nullptr)
+            return;
+
+        _deleteTree(n->left);
+        _deleteTree(n->right);
+        _deleteNode(n);
+    }
+
+private:
+    std::atomic<node_pointer> _root;
+    std::atomic<size_type> _epoch; // number of the current write, starts from 1
+    mutable ReaderSlot _readers[maxReaders];
+    Compare _cmp;
+    NodeAllocator _nodeAlloc;
+    DynArr<retired_type, RetiredAllocator> _retired;
+    DynArr<node_pointer, NodePointerAllocator> _created; // nodes of the write which is not published
+};
+
+#endif // CONCURRENT_AVL_TREE_HPP_INCLUDED
@@ -8,6 +8,11 @@
 #include <initializer_list>
 #include <cstddef>
 #include <iterator>
+#include <iostream>
+#include <cstring>
+#include <type_traits>
+#include <algorithm>
+#include <utility>
 
 
 template < typename T >
@@ -22,9 +27,12 @@ public:
     typedef value_type& reference;
     typedef const value_type& const_reference;
 
-template < typename T1, typename Allocator >
+template < typename T1, typename Allocator, typename Growth >
     friend class DynArr;
 
+template < typename T1, std::size_t N, typename Allocator >
+    friend class SmallArr;
+
 template < typename T1 >
     friend class RandomAccessIterator;
 
@@ -62,20 +70,13 @@ public:
         return *this;
     }
 
-    reference operator*()
-    {
-        return *_p;
-    }
-    const_reference operator*() const
+    // constness of iterator does not change constness of element
+    reference operator*() const
     {
         return *_p;
     }
 
-    pointer operator->()
-    {
-        return _p;
-    }
-    const_pointer operator->() const
+    pointer operator->() const
     {
         return _p;
     }
@@ -85,7 +86,7 @@ public:
         _p++;
         return *this;
     }
-    RandomAccessIterator& operator++(int)
+    RandomAccessIterator operator++(int)
     {
         RandomAccessIterator<value_type>oldIter(*this);
         _p++;
@@ -97,7 +98,7 @@ public:
         _p--;
         return *this;
     }
-    RandomAccessIterator& operator--(int)
+    RandomAccessIterator operator--(int)
     {
         RandomAccessIterator<value_type>oldIter(*this);
         _p--;
@@ -113,11 +114,7 @@ public:
         return !(*this == other);
     }
 
-    value_type& operator[](size_t n)
-    {
-        return _p[n];
-    }
-    const value_type& operator[](size_t n) const
+    reference operator[](size_t n) const
     {
         return _p[n];
     }
@@ -131,12 +128,12 @@ public:
     {
         return *this += -n;
     }
-    RandomAccessIterator& operator+(difference_type n)
+    RandomAccessIterator operator+(difference_type n) const
     {
         RandomAccessIterator it = *this;
         return it += n;
     }
-    RandomAccessIterator& operator-(difference_type n)
+    RandomAccessIterator operator-(difference_type n) const
     {
         return *this + (-n);
     }
@@ -157,13 +154,84 @@ private:
 };
 
 // https://en.cppreference.com/w/cpp/container/vector
-template < typename T, typename Allocator = std::allocator<T> >
+// objects of such type can be moved to other memory by copying their bytes
+// (old copy is not destroyed then), may be specialized for other types
+template < typename T >
+struct is_trivially_relocatable: std::is_trivially_copyable<T>
+{};
+
+// growth policies give new capacity (not less than required)
+// for array which has current capacity and elements of elemSize bytes
+
+// capacity is doubled: few reallocations, peak memory is 3 times the size
+struct DoublingGrowth
+{
+    static std::size_t grow(std::size_t current, std::size_t required, std::size_t) noexcept
+    {
+        return std::max(required, current * 2);
+    }
+};
+
+// capacity is multiplied by 1.5: more reallocations, peak memory is 2.5 times the size
+struct GeometricGrowth
+{
+    static std::size_t grow(std::size_t current, std::size_t required, std::size_t) noexcept
+    {
+        return std::max(required, current + current / 2);
+    }
+};
+
+// capacity is increased by Step elements: peak memory is about 2 times the size,
+// but filling n elements costs O(n^2 / Step) moves
+template < std::size_t Step >
+struct FixedStepGrowth
+{
+    static std::size_t grow(std::size_t, std::size_t required, std::size_t) noexcept
+    {
+        return (required + Step - 1) / Step * Step;
+    }
+};
+
+// capacity of Growth is rounded up to whole pages, the last page is not wasted
+template < typename Growth = DoublingGrowth, std::size_t PageSize = 4096 >
+struct PageRoundedGrowth
+{
+    static std::size_t grow(std::size_t current, std::size_t required, std::size_t elemSize) noexcept
+    {
+        auto bytes = Growth::grow(current, required, elemSize) * elemSize;
+        return (bytes + PageSize - 1) / PageSize * PageSize / elemSize;
+    }
+};
+
+// allocator may grow memory without copying (e.g. by mremap), it has
+// pointer reallocate(pointer p, size_type oldCount, size_type newCount), which
+// gives memory with bytes of old memory or nullptr if it is not able to do it
+template < typename Alloc, typename = void >
+struct has_reallocate: std::false_type
+{};
+template < typename Alloc >
+struct has_reallocate< Alloc, decltype((void)std::declval<Alloc&>().reallocate(
+    std::declval<typename std::allocator_traits<Alloc>::pointer>(), std::size_t(), std::size_t())) >:
+    std::true_type
+{};
+
+// what reallocations of one array cost
+struct GrowthStats
+{
+    std::size_t reallocations = 0;  // all changes of capacity
+    std::size_t inPlace = 0;        // reallocations done by allocator without copying
+    std::size_t relocated = 0;      // elements moved to new memory
+    std::size_t peakBytes = 0;      // max of memory held at once (old and new buffers)
+};
+
+template < typename T, typename Allocator = std::allocator<T>, typename Growth = DoublingGrowth >
 class DynArr
 {
 public:
     // member types
     typedef T value_type;
     typedef Allocator allocator_type;
+    typedef Growth growth_policy;
     typedef std::size_t size_type;
     typedef std::ptrdiff_t difference_type;
     typedef value_type& reference;
@@ -176,6 +244,9 @@ public:
 private:
     template < typename Alloc >
     using traits = std::allocator_traits<Alloc>;
+    // memory of elements may be grown by allocator
+    typedef std::integral_constant<bool, has_reallocate<Allocator>::value && 
+        is_trivially_relocatable<T>::value> can_reallocate;
 
 public:
     // member functions
@@ -191,7 +262,7 @@ public:
     DynArr(size_type count, const T& value, const Allocator& alloc = Allocator()):
             DynArr(alloc)
     {
-        _cap = calcCapacity(count);
+        _cap = count;
         _p = traits<Allocator>::allocate(_alloc, capacity());
         for (size_type i = 0; i < count; i++)
             push_back(value);
@@ -202,45 +273,48 @@ public:
     explicit DynArr(size_type count, const Allocator& alloc = Allocator()):
             DynArr(alloc)
     {
-        _cap = calcCapacity(count);
+        _cap = count;
         _p = traits<Allocator>::allocate(_alloc, capacity());
         for (size_type i = 0; i < count; i++)
-            push_back(value_type());
+            emplace_back();
 
         _size = count;
     }
 
     DynArr(const DynArr& other): DynArr(other.get_allocator())
     {
-        _cap = calcCapacity(other.size());
+        _cap = other.size();
         _p = traits<Allocator>::allocate(_alloc, capacity());
+        if (std::is_trivially_copyable<T>::value)
+        {
+            _copyBytes(_p, other._p, other.size());
+            _size = other.size();
+            return;
+        }
         for (size_type i = 0; i < other.size(); i++)
             push_back(other.at(i));
     }
 
     DynArr(const DynArr& other, const Allocator& alloc): DynArr(alloc)
     {
-        _cap = calcCapacity(other.size());
+        _cap = other.size();
         _p = traits<Allocator>::allocate(_alloc, capacity());
         for (size_type i = 0; i < other.size(); i++)
             push_back(other.at(i));
-
-        other.clear();
     }
 
-    DynArr(DynArr&& other) noexcept: DynArr(other.get_allocator())
+    DynArr(DynArr&& other) noexcept: 
+            _p(other._p), _size(other._size), _cap(other._cap), _alloc(other._alloc)
     {
-        _cap = calcCapacity(other.size());
-        _p = traits<Allocator>::allocate(_alloc, capacity());
-        for (size_type i = 0; i < other.size(); i++)
-            push_back(std::move_if_noexcept(other.at(i)));
-
-        other.clear();
+        // taking the buffer of other
+        other._p = nullptr;
+        other._size = 0;
+        other._cap = 0;
     }
     
     DynArr(DynArr&& other, const Allocator& alloc): DynArr(alloc)
     {
-        _cap = calcCapacity(other.size());
+        _cap = other.size();
         _p = traits<Allocator>::allocate(_alloc, capacity());
         for (size_type i = 0; i < other.size(); i++)
             push_back(std::move_if_noexcept(other.at(i)));
@@ -251,7 +325,7 @@ public:
     DynArr(std::initializer_list<T> init, const Allocator& alloc = Allocator()): 
             DynArr(alloc)
     {
-        _cap = calcCapacity(init.size());
+        _cap = init.size();
         _p = traits<Allocator>::allocate(_alloc, capacity());
         for (auto i = init.begin(); i != init.end(); i++)
             push_back(*i);
@@ -291,9 +365,36 @@ public:
         return _p[pos];
     }
 
+    reference front()
+    {
+        return _p[0];
+    }
+    const_reference front() const
+    {
+        return _p[0];
+    }
+
+    reference back()
+    {
+        return _p[size() - 1];
+    }
+    const_reference back() const
+    {
+        return _p[size() - 1];
+    }
+
+    pointer data() noexcept
+    {
+        return _p;
+    }
+    const_pointer data() const noexcept
+    {
+        return _p;
+    }
+
     allocator_type get_allocator() const noexcept
     {
-        _alloc;
+        return _alloc;
     }
 
     // iterators
@@ -307,7 +408,7 @@ public:
     }
     const_iterator cbegin() const noexcept
     {
-        const_iterator(_p);
+        return const_iterator(_p);
     }
 
     iterator end() noexcept
@@ -338,17 +439,23 @@ public:
     {
         return _cap;
     }
+
+    const GrowthStats& growth_stats() const noexcept
+    {
+        return _stats;
+    }
     
-    void shrink_to_fit()
+    // after reserve(n) adding elements up to size n does not reallocate memory
+    void reserve(size_type newCap)
     {
-        auto newCap = size();
-        auto newP = traits<Allocator>::allocate(_alloc, newCap);
-        for (size_type i = 0; i < size(); i++)
-            traits<Allocator>::construct(_alloc, newP + i, std::move_if_noexcept(_p[i]));
+        if (newCap > capacity())
+            _reallocate(newCap);
+    }
 
-        traits<Allocator>::deallocate(_alloc, _p, capacity());
-        _p = newP;
-        _cap = newCap;
+    void shrink_to_fit()
+    {
+        if (size() < capacity())
+            _reallocate(size());
     }
 
     // modifiers
@@ -361,114 +468,425 @@ public:
         catch(...)
         {}
         traits<Allocator>::deallocate(_alloc, _p, capacity());
+        _p = nullptr;
         _cap = 0;
     }
 
     void push_back(const T& value)
     {
-        if (size() < capacity())
+        emplace_back(value);
+    }
+    
+    void push_back(T&& value)
+    {
+        emplace_back(std::move(value));
+    }
+    
+    // element is constructed from args right in the array, without temporary
+    template <typename... Args >
+        reference emplace_back(Args&&... args)
         {
-            traits<Allocator>::construct(_alloc, _p + size(), value);
-            _size++;
+            if (size() < capacity())
+            {
+                traits<Allocator>::construct(_alloc, _p + size(), std::forward<Args>(args)...);
+                _size++;
+                return back();
+            }
+            auto newCap = Growth::grow(capacity(), size() + 1, sizeof(value_type));
+            _emplaceGrowing(can_reallocate(), newCap, std::forward<Args>(args)...);
+            return back();
         }
+    
+    void pop_back()
+    {
+        if (empty())
+            throw std::out_of_range(std::string("DynArr::pop_back: this.size() is 0"));
+
+        _destroyFrom(size() - 1);
+    }
+    
+    // new elements are value-initialized, array of type without
+    // default constructor can only be shrinked
+    void resize(size_type count)
+    {
+        if (count <= size())
+            return _destroyFrom(count);
+
+        if constexpr (!std::is_default_constructible<T>::value)
+            throw std::out_of_range(std::string("DynArr::resize: count > this.size() (which is ") + 
+                    std::to_string(size()) + ")");
         else
+            _growValueInit(count);
+    }
+
+    void resize(size_type count, const T& val)
+    {
+        if (count <= size())
+            return _destroyFrom(count);
+
+        if (count > capacity() && _isElement(val))
+        {
+            // val is element of this array, it is moved by reallocation
+            value_type copy(val);
+            return resize(count, copy);
+        }
+        _reserveFor(count);
+        auto oldSize = size();
+        try
+        {
+            for (; size() < count; _size++)
+                traits<Allocator>::construct(_alloc, _p + size(), val);
+        }
+        catch(...)
+        {
+            _destroyFrom(oldSize);
+            throw;
+        }
+    }
+
+    // new elements are default-initialized: for trivial types
+    // memory is not written, the caller fills it (e.g. by parser)
+    void resize_default_init(size_type count)
+    {
+        if (count <= size())
+            return _destroyFrom(count);
+
+        _reserveFor(count);
+        if (std::is_trivially_default_constructible<T>::value)
+        {
+            _size = count;
+            return;
+        }
+        auto oldSize = size();
+        try
+        {
+            for (; size() < count; _size++)
+                ::new ((void*)(_p + size())) value_type;
+        }
+        catch(...)
         {
-            auto newCap = calcCapacity(size() + 1);
-            auto newP = traits<Allocator>::allocate(_alloc, newCap);
+            _destroyFrom(oldSize);
+            throw;
+        }
+    }
+
+    // adds elements of [first, last) to the end, memory is reserved once
+    // if the size of the range is known
+    // (templates with iterators are not used for (count, value) arguments)
+    template < typename InputIt, typename = typename std::iterator_traits<InputIt>::iterator_category >
+    void append(InputIt first, InputIt last)
+    {
+        _append(first, last, typename std::iterator_traits<InputIt>::iterator_category());
+    }
+
+    void append(std::initializer_list<T> init)
+    {
+        append(init.begin(), init.end());
+    }
+
+    // elements of [first, last) are inserted before pos,
+    // gives iterator to the first inserted element
+    template < typename InputIt, typename = typename std::iterator_traits<InputIt>::iterator_category >
+    iterator insert(const_iterator pos, InputIt first, InputIt last)
+    {
+        size_type index = pos - cbegin();
+        auto oldSize = size();
+        try
+        {
+            append(first, last);
+        }
+        catch(...)
+        {
+            _destroyFrom(oldSize);
+            throw;
+        }
+        std::rotate(_p + index, _p + oldSize, _p + size());
+        return begin() + index;
+    }
+
+    iterator insert(const_iterator pos, std::initializer_list<T> init)
+    {
+        return insert(pos, init.begin(), init.end());
+    }
+
+    // capacity is kept, [first, last) must not be in this array
+    template < typename InputIt, typename = typename std::iterator_traits<InputIt>::iterator_category >
+    void assign(InputIt first, InputIt last)
+    {
+        _destroyFrom(0);
+        append(first, last);
+    }
+
+    void assign(size_type count, const T& value)
+    {
+        if (_isElement(value))
+        {
+            value_type copy(value);
+            return assign(count, copy);
+        }
+        _destroyFrom(0);
+        resize(count, value);
+    }
+
+    void assign(std::initializer_list<T> init)
+    {
+        assign(init.begin(), init.end());
+    }
+
+private:
+    void _destroyFrom(size_type count) noexcept
+    {
+        for (size_type i = count; i < size(); i++)
+            traits<Allocator>::destroy(_alloc, _p + i);
+
+        _size = count;
+    }
+
+    void _growValueInit(size_type count)
+    {
+        _reserveFor(count);
+        auto oldSize = size();
+        try
+        {
+            for (; size() < count; _size++)
+                traits<Allocator>::construct(_alloc, _p + size());
+        }
+        catch(...)
+        {
+            _destroyFrom(oldSize);
+            throw;
+        }
+    }
+
+    bool _isElement(const T& value) const noexcept
+    {
+        return _p <= &value && &value < _p + size();
+    }
+
+    // capacity for count elements, chosen by growth policy
+    void _reserveFor(size_type count)
+    {
+        if (count > capacity())
+            _reallocate(Growth::grow(capacity(), count, sizeof(value_type)));
+    }
+
+    template < typename InputIt >
+    void _append(InputIt first, InputIt last, std::input_iterator_tag)
+    {
+        for (; first != last; ++first)
+            emplace_back(*first);
+    }
+
+    template < typename ForwardIt >
+    void _append(ForwardIt first, ForwardIt last, std::forward_iterator_tag)
+    {
+        size_type count = std::distance(first, last);
+        if (size() + count > capacity() && _isInArray(first, count))
+            return _appendFromArray(first, count);
+
+        // memory may be grown by allocator without copying
+        _reserveFor(size() + count);
+        _constructRange(_p + size(), first, count);
+        _size += count;
+    }
+
+    // range of this array is copied to new memory before the elements are moved
+    template < typename ForwardIt >
+    void _appendFromArray(ForwardIt first, size_type count)
+    {
+        auto newCap = Growth::grow(capacity(), size() + count, sizeof(value_type));
+        auto newP = traits<Allocator>::allocate(_alloc, newCap);
+        try
+        {
+            _constructRange(newP + size(), first, count);
+        }
+        catch(...)
+        {
+            traits<Allocator>::deallocate(_alloc, newP, newCap);
+            throw;
+        }
+        try
+        {
+            _moveTo(newP, newCap);
+        }
+        catch(...)
+        {
+            for (size_type i = 0; i < count; i++)
+                traits<Allocator>::destroy(_alloc, newP + size() + i);
+            traits<Allocator>::deallocate(_alloc, newP, newCap);
+            throw;
+        }
+        _size += count;
+    }
+
+    // only iterators giving references to T may go over this array
+    template < typename ForwardIt >
+    bool _isInArray(ForwardIt first, size_type count) const
+    {
+        typedef typename std::iterator_traits<ForwardIt>::reference ref;
+        if constexpr (std::is_reference<ref>::value &&
+                std::is_same<typename std::decay<ref>::type, value_type>::value)
+            return count != 0 && _isElement(*first);
+        else
+            return false;
+    }
+
+    // on exception constructed elements are destroyed
+    template < typename ForwardIt >
+    void _constructRange(pointer dest, ForwardIt first, size_type count)
+    {
+        // contiguous range of the same trivial type is copied by one memcpy
+        constexpr bool isContiguous = std::is_same<ForwardIt, pointer>::value ||
+            std::is_same<ForwardIt, const_pointer>::value ||
+            std::is_same<ForwardIt, iterator>::value ||
+            std::is_same<ForwardIt, const_iterator>::value;
+        if constexpr (isContiguous && std::is_trivially_copyable<T>::value)
+        {
+            if (count != 0)
+                _copyBytes(dest, &*first, count);
+        }
+        else
+        {
+            size_type i = 0;
             try
             {
-                traits<Allocator>::construct(_alloc, newP + size(), value);
+                for (; i < count; i++, ++first)
+                    traits<Allocator>::construct(_alloc, dest + i, *first);
             }
             catch(...)
             {
-                traits<Allocator>::deallocate(_alloc, newP, newCap);
+                for (size_type j = 0; j < i; j++)
+                    traits<Allocator>::destroy(_alloc, dest + j);
                 throw;
             }
-            
-            for (size_type i = 0; i < size(); i++)
-                traits<Allocator>::construct(_alloc, newP + i, std::move_if_noexcept(_p[i]));
-
-            traits<Allocator>::deallocate(_alloc, _p, capacity());
-            _p = newP;
-            _size++;
-            _cap = newCap;
         }
     }
-    
-    void push_back(T&& value)
+
+    // elements are moved to new memory, old memory is given back
+    void _reallocate(size_type newCap)
     {
-        if (size() < capacity())
+        if (_reallocateInPlace(newCap))
+            return;
+
+        auto newP = traits<Allocator>::allocate(_alloc, newCap);
+        try
         {
-            traits<Allocator>::construct(_alloc, _p + size(), value);
-            _size++;
+            _moveTo(newP, newCap);
         }
+        catch(...)
+        {
+            traits<Allocator>::deallocate(_alloc, newP, newCap);
+            throw;
+        }
+    }
+
+    // on exception this array is not changed, newP is left empty
+    void _moveTo(pointer newP, size_type newCap)
+    {
+        if (is_trivially_relocatable<T>::value)
+            _copyBytes(newP, _p, size());
         else
         {
-            auto newCap = calcCapacity(size() + 1);
-            auto newP = traits<Allocator>::allocate(_alloc, newCap);
+            size_type i = 0;
             try
             {
-                traits<Allocator>::construct(_alloc, newP + size(), std::move(value));
+                for (; i < size(); i++)
+                    traits<Allocator>::construct(_alloc, newP + i, std::move_if_noexcept(_p[i]));
             }
             catch(...)
             {
-                traits<Allocator>::deallocate(_alloc, newP, newCap);
+                for (size_type j = 0; j < i; j++)
+                    traits<Allocator>::destroy(_alloc, newP + j);
                 throw;
             }
-            
-            for (size_type i = 0; i < size(); i++)
-                traits<Allocator>::construct(_alloc, newP + i, std::move_if_noexcept(_p[i]));
-
-            traits<Allocator>::deallocate(_alloc, _p, capacity());
-            _p = newP;
-            _size++;
-            _cap = calcCapacity(size());
+            for (i = 0; i < size(); i++)
+                traits<Allocator>::destroy(_alloc, _p + i);
         }
+        _countReallocation(newCap, size());
+        traits<Allocator>::deallocate(_alloc, _p, capacity());
+        _p = newP;
+        _cap = newCap;
     }
-    
-    template <typename... Args >
-        reference emplace_back(Args&&... args)
+
+    // new element is constructed in new memory, then old elements are moved there
+    template < typename... Args >
+    void _emplaceGrowing(std::false_type, size_type newCap, Args&&... args)
+    {
+        auto newP = traits<Allocator>::allocate(_alloc, newCap);
+        try
         {
-            push_back(value_type(std::forward<Args>(args)...));
-            return at(size()-1);
+            // args may refer to elements of this array, so they are used before moving
+            traits<Allocator>::construct(_alloc, newP + size(), std::forward<Args>(args)...);
         }
-    
-    void pop_back()
-    {
-        resize(size() - 1);
+        catch(...)
+        {
+            traits<Allocator>::deallocate(_alloc, newP, newCap);
+            throw;
+        }
+        try
+        {
+            _moveTo(newP, newCap);
+        }
+        catch(...)
+        {
+            traits<Allocator>::destroy(_alloc, newP + size());
+            traits<Allocator>::deallocate(_alloc, newP, newCap);
+            throw;
+        }
+        _size++;
     }
-    
-    void resize(size_type count)
+
+    template < typename... Args >
+    void _emplaceGrowing(std::true_type, size_type newCap, Args&&... args)
     {
-        if (!(count <= size()))
-            throw std::out_of_range(std::string("DynArr::resize: count > this.size() (which is ") + 
-                    std::to_string(size()) + ")");
+        // args may refer to elements of this array which are moved by allocator
+        value_type value(std::forward<Args>(args)...);
+        if (!_reallocateInPlace(newCap))
+            return _emplaceGrowing(std::false_type(), newCap, std::move(value));
 
-        for (size_type i = count; i < size(); i++)
-            traits<Allocator>::destroy(_alloc, _p + i);
-    
-        _size = count;
+        traits<Allocator>::construct(_alloc, _p + size(), std::move(value));
+        _size++;
     }
 
-    void resize(size_type count, const T& val)
+    // allocators without reallocate are not asked (explicit instantiation
+    // of DynArr compiles all members, so it is not an overload)
+    bool _reallocateInPlace(size_type newCap)
     {
-        if (count < size())
+        if constexpr (can_reallocate::value)
         {
-            for (size_type i = count; i < size(); i++)
-                traits<Allocator>::destroy(_alloc, _p + i);
-        
-            _size = count;
+            if (_p == nullptr)
+                return false;
+
+            auto newP = _alloc.reallocate(_p, capacity(), newCap);
+            if (newP == nullptr)
+                return false;
+
+            _stats.inPlace++;
+            _countReallocation(newCap, 0);
+            _p = newP;
+            _cap = newCap;
+            return true;
+        }
+        else
+        {
+            (void)newCap;
+            return false;
         }
-        else if (count > size())
-            for (; size() < count;)
-                push_back(val);
     }
 
-private:
-    size_type calcCapacity(size_type sz) const noexcept
+    void _countReallocation(size_type newCap, size_type relocated) noexcept
+    {
+        _stats.reallocations++;
+        _stats.relocated += relocated;
+        auto bytes = (relocated == 0 ? std::max(capacity(), newCap) : capacity() + newCap) * sizeof(value_type);
+        _stats.peakBytes = std::max(_stats.peakBytes, bytes);
+    }
+
+    static void _copyBytes(pointer dest, const_pointer src, size_type count) noexcept
     {
-        // return std::pow(2, (size_type)std::log2(sz) + 1);
-        return sz * 2;
+        // memcpy must not get nullptr even for zero count
+        if (count != 0)
+            std::memcpy((void*)dest, (const void*)src, count * sizeof(value_type));
     }
 
 private:
@@ -477,15 +895,16 @@ private:
     size_type _size;
     size_type _cap;
     Allocator _alloc;
+    GrowthStats _stats;
 };
 
 // non-member functions
-template < typename T, typename Alloc >
-std::ostream& operator<<(std::ostream& os, const DynArr<T, Alloc>& arr)
+template < typename T, typename Alloc, typename Growth >
+std::ostream& operator<<(std::ostream& os, const DynArr<T, Alloc, Growth>& arr)
 {
     if (arr.size() == 0)
     {
-        std::cout << "[]";
+        os << "[]";
         return os;
     }
     os << "[";
@@ -496,16 +915,16 @@ std::ostream& operator<<(std::ostream& os, const DynArr<T, Alloc>& arr)
     return os;
 }
 
-template<class T, class Allocator>
-    typename DynArr<T, Allocator>::iterator begin(const DynArr<T, Allocator>& arr)
+template<class T, class Allocator, class Growth>
+    typename DynArr<T, Allocator, Growth>::const_iterator begin(const DynArr<T, Allocator, Growth>& arr)
     {
         return arr.begin();
     }
 
-template<class T, class Allocator>
-    typename DynArr<T, Allocator>::iterator end(const DynArr<T, Allocator>& arr)
+template<class T, class Allocator, class Growth>
+    typename DynArr<T, Allocator, Growth>::const_iterator end(const DynArr<T, Allocator, Growth>& arr)
     {
-        arr.end();
+        return arr.end();
     }
 
 
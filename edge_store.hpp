@@ -0,0 +1,387 @@
+#ifndef EDGE_STORE_HPP_INCLUDED
+#define EDGE_STORE_HPP_INCLUDED
+
+#include <memory>
+#include <cstddef>
+#include <iterator>
+#include <utility>
+#include <type_traits>
+
+#include "dynamic_array.hpp"
+
+//! edges of graph as structure of arrays: ends and weights of edges
+//! are kept in three separate DynArr, so pass over weights (sorting
+//! comparisons, partitioning) reads only weights. iterator is random
+//! access and gives EdgeRef, which refers to the fields of one edge in
+//! all arrays, so timSort and the Kruskal loop work on the store directly
+
+// one edge as separate object
+template < typename Vertex, typename Weight >
+struct EdgeValue
+{
+    Vertex from;
+    Vertex to;
+    Weight weight;
+
+    EdgeValue() = default;
+    EdgeValue(const Vertex& from, const Vertex& to, const Weight& weight):
+        from(from), to(to), weight(weight)
+    {}
+};
+
+// reference to one edge in the store, assignment changes the edge in the store
+// (Vertex and Weight are const for constant store)
+template < typename Vertex, typename Weight >
+class EdgeRef
+{
+public:
+    typedef EdgeValue<typename std::remove_const<Vertex>::type,
+        typename std::remove_const<Weight>::type> value_type;
+
+public:
+    EdgeRef(Vertex& from, Vertex& to, Weight& weight):
+        from(from), to(to), weight(weight)
+    {}
+    EdgeRef(const EdgeRef& other) = default;
+
+    EdgeRef& operator=(const EdgeRef& other)
+    {
+        from = other.from;
+        to = other.to;
+        weight = other.weight;
+        return *this;
+    }
+    EdgeRef& operator=(const value_type& value)
+    {
+        from = value.from;
+        to = value.to;
+        weight = value.weight;
+        return *this;
+    }
+    EdgeRef& operator=(value_type&& value)
+    {
+        from = std::move(value.from);
+        to = std::move(value.to);
+        weight = std::move(value.weight);
+        return *this;
+    }
+
+    operator value_type() const
+    {
+        return value_type(from, to, weight);
+    }
+
+    // swaps edges in the store, not references
+    friend void swap(EdgeRef a, EdgeRef b)
+    {
+        using std::swap;
+        swap(a.from, b.from);
+        swap(a.to, b.to);
+        swap(a.weight, b.weight);
+    }
+
+public:
+    Vertex& from;
+    Vertex& to;
+    Weight& weight;
+};
+
+// edges are compared only by weights, for EdgeValue and EdgeRef
+struct EdgeWeightLess
+{
+    template < typename A, typename B >
+    bool operator()(const A& a, const B& b) const
+    {
+        return a.weight < b.weight;
+    }
+};
+
+template < typename Vertex, typename Weight >
+class EdgeIterator
+{
+public:
+    typedef std::random_access_iterator_tag iterator_category;
+    typedef EdgeValue<typename std::remove_const<Vertex>::type,
+        typename std::remove_const<Weight>::type> value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef EdgeRef<Vertex, Weight> reference;
+    typedef void pointer;
+
+template < typename Vertex1, typename Weight1, typename Allocator >
+    friend class EdgeStore;
+
+template < typename Vertex1, typename Weight1 >
+    friend class EdgeIterator;
+
+private:
+    EdgeIterator(Vertex* from, Vertex* to, Weight* weight, difference_type pos):
+        _from(from), _to(to), _weight(weight), _pos(pos)
+    {}
+
+public:
+    EdgeIterator(): _from(nullptr), _to(nullptr), _weight(nullptr), _pos(0)
+    {}
+    EdgeIterator(const EdgeIterator& other) = default;
+    EdgeIterator& operator=(const EdgeIterator& other) = default;
+
+    ~EdgeIterator()
+    {}
+
+    reference operator*() const
+    {
+        return reference(_from[_pos], _to[_pos], _weight[_pos]);
+    }
+
+    reference operator[](difference_type n) const
+    {
+        return *(*this + n);
+    }
+
+    EdgeIterator& operator++()
+    {
+        _pos++;
+        return *this;
+    }
+    EdgeIterator operator++(int)
+    {
+        EdgeIterator oldIter(*this);
+        _pos++;
+        return oldIter;
+    }
+
+    EdgeIterator& operator--()
+    {
+        _pos--;
+        return *this;
+    }
+    EdgeIterator operator--(int)
+    {
+        EdgeIterator oldIter(*this);
+        _pos--;
+        return oldIter;
+    }
+
+    EdgeIterator& operator+=(difference_type n)
+    {
+        _pos += n;
+        return *this;
+    }
+    EdgeIterator& operator-=(difference_type n)
+    {
+        return *this += -n;
+    }
+    EdgeIterator operator+(difference_type n) const
+    {
+        EdgeIterator it = *this;
+        return it += n;
+    }
+    EdgeIterator operator-(difference_type n) const
+    {
+        return *this + (-n);
+    }
+
+    difference_type operator-(const EdgeIterator& other) const
+    {
+        return _pos - other._pos;
+    }
+
+    bool operator==(const EdgeIterator& other) const
+    {
+        return _pos == other._pos;
+    }
+    bool operator!=(const EdgeIterator& other) const
+    {
+        return !(*this == other);
+    }
+    bool operator<(const EdgeIterator& other) const
+    {
+        return _pos < other._pos;
+    }
+    bool operator>(const EdgeIterator& other) const
+    {
+        return other < *this;
+    }
+    bool operator<=(const EdgeIterator& other) const
+    {
+        return !(other < *this);
+    }
+    bool operator>=(const EdgeIterator& other) const
+    {
+        return !(*this < other);
+    }
+
+    operator EdgeIterator<const Vertex, const Weight>() const noexcept
+    {
+        return EdgeIterator<const Vertex, const Weight>(_from, _to, _weight, _pos);
+    }
+
+private:
+    // positions are counted from the beginning of the arrays
+    Vertex* _from;
+    Vertex* _to;
+    Weight* _weight;
+    difference_type _pos;
+};
+
+template < typename Vertex, typename Weight, typename Allocator = std::allocator<Weight> >
+class EdgeStore
+{
+public:
+    // member types
+    typedef EdgeValue<Vertex, Weight> value_type;
+    typedef Vertex vertex_type;
+    typedef Weight weight_type;
+    typedef Allocator allocator_type;
+    typedef std::size_t size_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef EdgeRef<Vertex, Weight> reference;
+    typedef EdgeRef<const Vertex, const Weight> const_reference;
+    typedef EdgeIterator<Vertex, Weight> iterator;
+    typedef EdgeIterator<const Vertex, const Weight> const_iterator;
+
+private:
+    typedef typename Allocator::template rebind<Vertex>::other VertexAllocator;
+    typedef typename Allocator::template rebind<Weight>::other WeightAllocator;
+
+public:
+    typedef DynArr<Vertex, VertexAllocator> vertices_type;
+    typedef DynArr<Weight, WeightAllocator> weights_type;
+
+public:
+    EdgeStore()
+    {}
+    explicit EdgeStore(const Allocator& alloc):
+        _from(VertexAllocator(alloc)), _to(VertexAllocator(alloc)), _weights(WeightAllocator(alloc))
+    {}
+    EdgeStore(const EdgeStore& other) = default;
+    EdgeStore(EdgeStore&& other) = default;
+
+    ~EdgeStore()
+    {}
+
+    // element access
+    reference operator[](size_type pos)
+    {
+        return reference(_from[pos], _to[pos], _weights[pos]);
+    }
+    const_reference operator[](size_type pos) const
+    {
+        return const_reference(_from[pos], _to[pos], _weights[pos]);
+    }
+
+    // separate fields of all edges
+    const vertices_type& froms() const noexcept
+    {
+        return _from;
+    }
+    const vertices_type& tos() const noexcept
+    {
+        return _to;
+    }
+    const weights_type& weights() const noexcept
+    {
+        return _weights;
+    }
+
+    allocator_type get_allocator() const noexcept
+    {
+        return allocator_type(_weights.get_allocator());
+    }
+
+    // iterators
+    iterator begin() noexcept
+    {
+        return iterator(_from.data(), _to.data(), _weights.data(), 0);
+    }
+    const_iterator begin() const noexcept
+    {
+        return const_iterator(_from.data(), _to.data(), _weights.data(), 0);
+    }
+    const_iterator cbegin() const noexcept
+    {
+        return begin();
+    }
+
+    iterator end() noexcept
+    {
+        return begin() + size();
+    }
+    const_iterator end() const noexcept
+    {
+        return begin() + size();
+    }
+    const_iterator cend() const noexcept
+    {
+        return end();
+    }
+
+    // capasity
+    bool empty() const noexcept
+    {
+        return size() == 0;
+    }
+    size_type size() const noexcept
+    {
+        return _weights.size();
+    }
+
+    void reserve(size_type newCap)
+    {
+        _from.reserve(newCap);
+        _to.reserve(newCap);
+        _weights.reserve(newCap);
+    }
+
+    // modifiers
+    void clear() noexcept
+    {
+        _from.clear();
+        _to.clear();
+        _weights.clear();
+    }
+
+    void push_back(const value_type& value)
+    {
+        emplace_back(value.from, value.to, value.weight);
+    }
+
+    // arrays keep the same size if one of them throws
+    template < typename V1, typename V2, typename W >
+    void emplace_back(V1&& from, V2&& to, W&& weight)
+    {
+        _from.emplace_back(std::forward<V1>(from));
+        try
+        {
+            _to.emplace_back(std::forward<V2>(to));
+            try
+            {
+                _weights.emplace_back(std::forward<W>(weight));
+            }
+            catch(...)
+            {
+                _to.pop_back();
+                throw;
+            }
+        }
+        catch(...)
+        {
+            _from.pop_back();
+            throw;
+        }
+    }
+
+    void pop_back()
+    {
+        _from.pop_back();
+        _to.pop_back();
+        _weights.pop_back();
+    }
+
+private:
+    vertices_type _from;
+    vertices_type _to;
+    weights_type _weights;
+};
+
+
+#endif // EDGE_STORE_HPP_INCLUDED
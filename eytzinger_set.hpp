@@ -0,0 +1,157 @@
+#ifndef EYTZINGER_SET_HPP_INCLUDED
+#define EYTZINGER_SET_HPP_INCLUDED
+
+#include <functional>
+#include <memory>
+#include <cstddef>
+#include <iterator>
+
+#include "dynamic_array.hpp"
+#include "avl_tree.hpp"
+#include "flat_set.hpp"
+
+//! frozen set of keys stored in BFS order of a complete binary tree
+//! (Eytzinger layout): children of position k are 2k and 2k + 1,
+//! so the search goes through the array from left to right and the
+//! next levels can be prefetched. Keys can not be changed after building,
+//! search gives the rank of the key (its position in sorted order).
+
+// https://algorithmica.org/en/eytzinger
+template < typename Key, typename Compare = std::less<Key>, typename Allocator = std::allocator<Key> >
+class EytzingerSet
+{
+public:
+    typedef Key key_type;
+    typedef Key value_type;
+    typedef std::size_t size_type;
+    typedef Compare key_compare;
+    typedef Allocator allocator_type;
+    typedef const value_type& const_reference;
+
+private:
+    typedef typename Allocator::template rebind<size_type>::other RankAllocator;
+
+public:
+    EytzingerSet(): _keys(1), _ranks(1)
+    {}
+    // [first, last) must be sorted and unique
+    template < typename ForwardIt >
+    EytzingerSet(ForwardIt first, ForwardIt last,
+        const Compare& comp = Compare(),
+        const Allocator& alloc = Allocator()):
+        _keys(std::distance(first, last) + 1, alloc),
+        _ranks(_keys.size(), RankAllocator(alloc)),
+        _cmp(comp)
+    {
+        // position 0 is not used, it means "not found"
+        size_type rank = 0;
+        _fill(first, 1, rank);
+    }
+    EytzingerSet(const EytzingerSet& other) = default;
+    EytzingerSet(EytzingerSet&& other) = default;
+
+    ~EytzingerSet()
+    {}
+
+    bool empty() const noexcept
+    {
+        return size() == 0;
+    }
+    size_type size() const noexcept
+    {
+        return _keys.size() - 1;
+    }
+
+    // rank of key or size() if there is no such key
+    size_type rank(const Key& key) const
+    {
+        auto k = _lowerBound(key);
+        if (k == 0 || _cmp(key, _keys[k]))
+            return size();
+
+        return _ranks[k];
+    }
+
+    // rank of the first key which is not less than key
+    size_type lower_rank(const Key& key) const
+    {
+        auto k = _lowerBound(key);
+        return k == 0 ? size() : _ranks[k];
+    }
+
+    bool contains(const Key& key) const
+    {
+        return rank(key) != size();
+    }
+
+private:
+    // puts sorted keys in in-order traversal of the implicit tree
+    template < typename ForwardIt >
+    void _fill(ForwardIt& it, size_type k, size_type& rank)
+    {
+        if (k > size())
+            return;
+
+        _fill(it, 2 * k, rank);
+        _keys[k] = *it;
+        _ranks[k] = rank++;
+        ++it;
+        _fill(it, 2 * k + 1, rank);
+    }
+
+    // position of the first key which is not less than key, 0 if there is no such key
+    size_type _lowerBound(const Key& key) const
+    {
+        const size_type n = size();
+        size_type k = 1;
+        for (; k <= n;)
+        {
+#if defined(__GNUC__)
+            // 16 descendants of k four levels below lie in one row
+            if (16 * k <= n)
+                __builtin_prefetch(&_keys[16 * k]);
+#endif
+            // going right if keys[k] < key, without branch
+            k = 2 * k + (size_type)_cmp(_keys[k], key);
+        }
+        // cancelling right turns and the last left turn
+        return k >> (_trailingOnes(k) + 1);
+    }
+
+    static size_type _trailingOnes(size_type k) noexcept
+    {
+#if defined(__GNUC__)
+        return __builtin_ctzll(~(unsigned long long)k);
+#else
+        size_type count = 0;
+        for (; k & 1; k >>= 1)
+            count++;
+
+        return count;
+#endif
+    }
+
+private:
+    DynArr<Key, Allocator> _keys;
+    DynArr<size_type, RankAllocator> _ranks;
+    Compare _cmp;
+};
+
+// making frozen copies of sets
+
+template < typename Key, typename Compare, typename Allocator, bool OrderStatistics >
+EytzingerSet<Key, Compare, Allocator> freeze(const AVLTree<Key, Compare, Allocator, OrderStatistics>& tree)
+{
+    typedef typename AVLTree<Key, Compare, Allocator, OrderStatistics>::const_left_root_right_iterator iterator;
+    return EytzingerSet<Key, Compare, Allocator>(iterator(tree.begin()), iterator(tree.end()),
+        tree.key_comp(), tree.get_allocator());
+}
+
+template < typename Key, typename Compare, typename Allocator >
+EytzingerSet<Key, Compare, Allocator> freeze(const FlatSet<Key, Compare, Allocator>& set)
+{
+    return EytzingerSet<Key, Compare, Allocator>(set.begin(), set.end(),
+        set.key_comp(), set.get_allocator());
+}
+
+#endif // EYTZINGER_SET_HPP_INCLUDED
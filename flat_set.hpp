@@ -0,0 +1,226 @@
+#ifndef FLAT_SET_HPP_INCLUDED
+#define FLAT_SET_HPP_INCLUDED
+
+#include <functional>
+#include <memory>
+#include <cstddef>
+#include <iterator>
+#include <utility>
+
+#include "dynamic_array.hpp"
+#include "tim_sort.hpp"
+
+//! ordered set stored as sorted DynArr without duplicates
+//! built once and searched many times: find is binary search,
+//! iteration goes through contiguous memory, insert and erase are O(n)
+
+// https://en.cppreference.com/w/cpp/container/flat_set
+template < typename Key, typename Compare = std::less<Key>, typename Allocator = std::allocator<Key> >
+class FlatSet
+{
+public:
+    typedef Key key_type;
+    typedef Key value_type;
+    typedef std::size_t size_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef Compare key_compare;
+    typedef Compare value_compare;
+    typedef Allocator allocator_type;
+    typedef value_type& reference;
+    typedef const value_type& const_reference;
+    typedef DynArr<Key, Allocator> container_type;
+    typedef typename container_type::const_iterator iterator;
+    typedef typename container_type::const_iterator const_iterator;
+
+public:
+    FlatSet()
+    {}
+    explicit FlatSet(const Compare& comp, const Allocator& alloc = Allocator()):
+        _keys(alloc), _cmp(comp)
+    {}
+    explicit FlatSet(const Allocator& alloc): _keys(alloc)
+    {}
+    template < typename InputIt >
+    FlatSet(InputIt first, InputIt last,
+        const Compare& comp = Compare(),
+        const Allocator& alloc = Allocator()):
+        _keys(alloc), _cmp(comp)
+    {
+        _keys.append(first, last);
+        _sortAndUnique();
+    }
+    // keys may be unsorted and contain duplicates
+    explicit FlatSet(container_type&& keys, const Compare& comp = Compare()):
+        _keys(std::move(keys)), _cmp(comp)
+    {
+        _sortAndUnique();
+    }
+    FlatSet(const FlatSet& other) = default;
+    FlatSet(FlatSet&& other) = default;
+    FlatSet(std::initializer_list<value_type> init,
+        const Compare& comp = Compare(),
+        const Allocator& alloc = Allocator()):
+        FlatSet(init.begin(), init.end(), comp, alloc)
+    {}
+
+    ~FlatSet()
+    {}
+
+    iterator begin() const noexcept
+    {
+        return _keys.begin();
+    }
+    const_iterator cbegin() const noexcept
+    {
+        return _keys.begin();
+    }
+
+    iterator end() const noexcept
+    {
+        return _keys.end();
+    }
+    const_iterator cend() const noexcept
+    {
+        return _keys.end();
+    }
+
+    bool empty() const noexcept
+    {
+        return _keys.empty();
+    }
+    size_type size() const noexcept
+    {
+        return _keys.size();
+    }
+
+    allocator_type get_allocator() const noexcept
+    {
+        return _keys.get_allocator();
+    }
+    key_compare key_comp() const
+    {
+        return _cmp;
+    }
+    value_compare value_comp() const
+    {
+        return _cmp;
+    }
+
+    const_reference operator[](size_type pos) const
+    {
+        return _keys[pos];
+    }
+
+    void clear() noexcept
+    {
+        _keys.clear();
+    }
+
+    std::pair<iterator,bool> insert(const value_type& value)
+    {
+        return _insert(value);
+    }
+    std::pair<iterator,bool> insert(value_type&& value)
+    {
+        return _insert(std::move(value));
+    }
+
+    size_type erase(const Key& key)
+    {
+        auto pos = _lowerBound(key);
+        if (pos == size() || _cmp(key, _keys[pos]))
+            return 0;
+
+        for (size_type i = pos + 1; i < size(); i++)
+            _keys[i - 1] = std::move(_keys[i]);
+        _keys.pop_back();
+        return 1;
+    }
+    void erase(const_iterator pos)
+    {
+        if (pos == end())
+            return;
+
+        erase(*pos);
+    }
+
+    iterator find(const Key& key) const
+    {
+        auto pos = _lowerBound(key);
+        if (pos == size() || _cmp(key, _keys[pos]))
+            return end();
+
+        return begin() + pos;
+    }
+
+    // position of key in sorted order or size() if there is no such key
+    size_type index_of(const Key& key) const
+    {
+        auto pos = _lowerBound(key);
+        if (pos == size() || _cmp(key, _keys[pos]))
+            return size();
+
+        return pos;
+    }
+
+    // gives sorted keys away, set becomes empty
+    container_type extract()
+    {
+        return std::move(_keys);
+    }
+
+private:
+    // index of the first key which is not less than key
+    size_type _lowerBound(const Key& key) const
+    {
+        size_type lo = 0, hi = size();
+        for (; lo < hi;)
+        {
+            auto mid = lo + (hi - lo) / 2;
+            if (_cmp(_keys[mid], key))
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        return lo;
+    }
+
+    template < typename V >
+    std::pair<iterator,bool> _insert(V&& value)
+    {
+        auto pos = _lowerBound(value);
+        if (pos < size() && !_cmp(value, _keys[pos]))
+            // this value already exists
+            return { begin() + pos, false };
+
+        // moving greater keys one place right
+        _keys.push_back(std::forward<V>(value));
+        for (size_type i = size() - 1; i > pos; i--)
+            std::swap(_keys[i], _keys[i - 1]);
+
+        return { begin() + pos, true };
+    }
+
+    void _sortAndUnique()
+    {
+        if (_keys.empty())
+            return;
+
+        timSort(_keys.begin(), _keys.end(), _cmp);
+        size_type count = 1;
+        for (size_type i = 1; i < _keys.size(); i++)
+            if (_cmp(_keys[count - 1], _keys[i]))
+            {
+                if (count != i)
+                    _keys[count] = std::move(_keys[i]);
+                count++;
+            }
+        _keys.resize(count);
+    }
+
+private:
+    container_type _keys;
+    Compare _cmp;
+};
+
+#endif // FLAT_SET_HPP_INCLUDED
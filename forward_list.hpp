@@ -4,6 +4,7 @@
 #include <memory>
 #include <cstddef>
 #include <iterator>
+#include <iostream>
 
 
 template < typename T >
@@ -109,7 +110,7 @@ public:
         _node = _node->next;
         return *this;
     }
-    ForwardIterator& operator++(int)
+    ForwardIterator operator++(int)
     {
         ForwardIterator<value_type>oldIter(*this);
         _node = _node->next;
@@ -169,18 +170,21 @@ public:
     {}
 
     explicit ForwardList(const Allocator& alloc):
-            _alloc(traits<Allocator>::select_on_container_copy_construction(alloc))
+            _alloc(traits<Allocator>::select_on_container_copy_construction(alloc)),
+            _nodeAlloc(_alloc)
     {}
 
     ForwardList(size_type count, const T& value, const Allocator& alloc = Allocator()):
-            _alloc(traits<Allocator>::select_on_container_copy_construction(alloc))
+            _alloc(traits<Allocator>::select_on_container_copy_construction(alloc)),
+            _nodeAlloc(_alloc)
     {
         for (size_type i = 0; i < count; i++)
             push_front(value);
     }
     
     explicit ForwardList(size_type count, const Allocator& alloc = Allocator()):
-            _alloc(traits<Allocator>::select_on_container_copy_construction(alloc))
+            _alloc(traits<Allocator>::select_on_container_copy_construction(alloc)),
+            _nodeAlloc(_alloc)
     {
         for (size_type i = 0; i < count; i++)
             push_front(value_type());
@@ -193,7 +197,8 @@ public:
     }
     
     ForwardList(const ForwardList& other, const Allocator& alloc):
-            _alloc(traits<Allocator>::select_on_container_copy_construction(alloc))
+            _alloc(traits<Allocator>::select_on_container_copy_construction(alloc)),
+            _nodeAlloc(_alloc)
     {
         for (auto iTh = before_begin(), iOt = other.begin(); iOt != other.end(); iTh++, iOt++)
             insert_after(iTh, *iOt);
@@ -206,14 +211,16 @@ public:
     }
     
     ForwardList(ForwardList&& other, const Allocator& alloc):
-            _alloc(traits<Allocator>::select_on_container_copy_construction(alloc))
+            _alloc(traits<Allocator>::select_on_container_copy_construction(alloc)),
+            _nodeAlloc(_alloc)
     {
         _beforeBegin._getNodePointer()->next = other._beforeBegin._getNodePointer()->next;
         other._beforeBegin._getNodePointer()->next = nullptr;
     }
     
     ForwardList(std::initializer_list<T> init, const Allocator& alloc = Allocator()):
-            _alloc(traits<Allocator>::select_on_container_copy_construction(alloc))
+            _alloc(traits<Allocator>::select_on_container_copy_construction(alloc)),
+            _nodeAlloc(_alloc)
     {
         for (auto iTh = before_begin(), iIn = init.begin(); iIn != init.end(); iTh++, iIn++)
             insert_after(iTh, *iIn);
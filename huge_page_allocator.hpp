@@ -0,0 +1,141 @@
+#ifndef HUGE_PAGE_ALLOCATOR_HPP_INCLUDED
+#define HUGE_PAGE_ALLOCATOR_HPP_INCLUDED
+
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+
+// allocator for big DynArr: memory is aligned to Alignment bytes (64 is
+// cache line and AVX-512 vector), blocks from hugeThreshold bytes are
+// backed by 2 MB pages to have less TLB misses on big arrays.
+// explicit huge pages (MAP_HUGETLB) are taken if the system has reserved
+// them, otherwise the block is aligned to 2 MB and given to transparent
+// huge pages by madvise(MADV_HUGEPAGE); if both are not available
+// (or not on Linux) it works as aligned operator new
+// https://www.kernel.org/doc/html/latest/admin-guide/mm/transhuge.html
+template < typename T, std::size_t Alignment = 64 >
+class HugePageAllocator
+{
+    static_assert(Alignment != 0 && (Alignment & (Alignment - 1)) == 0,
+        "HugePageAllocator: Alignment must be a power of 2");
+
+public:
+    typedef T value_type;
+    typedef value_type* pointer;
+    typedef const value_type* const_pointer;
+    typedef value_type& reference;
+    typedef const value_type& const_reference;
+    typedef std::size_t size_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef std::true_type is_always_equal;
+
+    static const size_type hugePageSize = 2 << 20;
+    static const size_type hugeThreshold = hugePageSize;
+    static const size_type alignment = Alignment < alignof(T) ? alignof(T) : Alignment;
+
+    template < typename U >
+    struct rebind
+    {
+        typedef HugePageAllocator<U, Alignment> other;
+    };
+
+public:
+    HugePageAllocator() noexcept
+    {}
+    HugePageAllocator(const HugePageAllocator& other) = default;
+    template < typename U >
+    HugePageAllocator(const HugePageAllocator<U, Alignment>&) noexcept
+    {}
+
+    pointer allocate(size_type n)
+    {
+        auto bytes = n * sizeof(value_type);
+        if (!_isHuge(bytes))
+            return static_cast<pointer>(::operator new(bytes, std::align_val_t(alignment)));
+
+        return static_cast<pointer>(_mapHuge(_hugePages(bytes)));
+    }
+
+    void deallocate(pointer p, size_type n) noexcept
+    {
+        auto bytes = n * sizeof(value_type);
+        if (!_isHuge(bytes))
+            ::operator delete(p, std::align_val_t(alignment));
+#if defined(__linux__)
+        else
+            munmap(p, _hugePages(bytes));
+#endif
+    }
+
+private:
+    static bool _isHuge(size_type bytes) noexcept
+    {
+#if defined(__linux__)
+        return bytes >= hugeThreshold;
+#else
+        (void)bytes;
+        return false;
+#endif
+    }
+
+    static size_type _hugePages(size_type bytes) noexcept
+    {
+        return (bytes + hugePageSize - 1) / hugePageSize * hugePageSize;
+    }
+
+    // size is multiple of hugePageSize, block is aligned to hugePageSize
+    static void* _mapHuge(size_type size)
+    {
+#if defined(__linux__)
+        const int prot = PROT_READ | PROT_WRITE;
+        const int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+        void* p;
+#if defined(MAP_HUGETLB)
+        p = mmap(nullptr, size, prot, flags | MAP_HUGETLB, -1, 0);
+        if (p != MAP_FAILED)
+            return p;
+#endif
+        // one more huge page to cut aligned block out of it
+        auto mapped = size + hugePageSize;
+        p = mmap(nullptr, mapped, prot, flags, -1, 0);
+        if (p == MAP_FAILED)
+            throw std::bad_alloc();
+
+        auto begin = reinterpret_cast<std::uintptr_t>(p);
+        auto aligned = (begin + hugePageSize - 1) / hugePageSize * hugePageSize;
+        if (aligned != begin)
+            munmap(p, aligned - begin);
+        if (aligned + size != begin + mapped)
+            munmap(reinterpret_cast<void*>(aligned + size), begin + mapped - (aligned + size));
+#if defined(MADV_HUGEPAGE)
+        // only a hint: without THP the block has usual pages
+        madvise(reinterpret_cast<void*>(aligned), size, MADV_HUGEPAGE);
+#endif
+        return reinterpret_cast<void*>(aligned);
+#else
+        (void)size;
+        return nullptr;
+#endif
+    }
+};
+
+template < typename T, typename U, std::size_t Alignment >
+bool operator==(const HugePageAllocator<T, Alignment>&, const HugePageAllocator<U, Alignment>&) noexcept
+{
+    return true;
+}
+template < typename T, typename U, std::size_t Alignment >
+bool operator!=(const HugePageAllocator<T, Alignment>&, const HugePageAllocator<U, Alignment>&) noexcept
+{
+    return false;
+}
+
+
+#endif // HUGE_PAGE_ALLOCATOR_HPP_INCLUDED
@@ -1,59 +1,27 @@
 #include <string>
 #include "tim_sort.hpp"
-#include "avl_tree.hpp"
+#include "flat_set.hpp"
 #include "sets_sys.hpp"
+#include "arena_allocator.hpp"
+#include "edge_store.hpp"
 
 typedef unsigned int value_type;
 
-// need to change timSort function (it must use only < and ==)
-struct Edge
-{
-    std::string from;
-    std::string to;
-    value_type weight;
+// all containers of one solve take memory from one arena
+template < typename T >
+using ArenaArr = DynArr<T, ArenaAllocator<T>>;
+typedef FlatSet<std::string, std::less<std::string>, ArenaAllocator<std::string>> NamesSet;
 
-    Edge(std::string&& from, std::string&& to, value_type weight):
-        from(std::move(from)), to(std::move(to)), weight(weight)
-    {}
-    Edge() = default;
-    Edge(const Edge&) = default;
-    Edge(Edge&&) = default;
-    Edge& operator=(const Edge& other) = default;
-    bool operator==(const Edge& other) const
-    {
-        return weight == other.weight;
-    }
-    bool operator!=(const Edge& other) const
-    {
-        return !(*this == other);
-    }
-    bool operator<(const Edge& other) const
-    {
-        return weight < other.weight;
-    }
-    bool operator<=(const Edge& other) const
-    {
-        return (*this < other) || (*this == other);
-    }
-    bool operator>(const Edge& other) const
-    {
-        return !(*this <= other);
-    }
-    bool operator>=(const Edge& other) const
-    {
-        return !(*this < other);
-    }
-};
-
-std::ostream& operator<<(std::ostream& os, const Edge& e)
-{
-    os << e.from << " " << e.to << " " << e.weight;
-    return os;
-}
+// ends of edge are indexes of names of tops
+typedef EdgeStore<unsigned int, value_type, ArenaAllocator<value_type>> Graph;
 
 int main()
 {
-    DynArr<Edge> graph;
+    Arena arena;
+    ArenaAllocator<char> alloc(arena);
+    // names of ends of edges go in pairs, in input order
+    ArenaArr<std::string> ends(alloc);
+    ArenaArr<value_type> weights(alloc);
     // get input
     for (;;)
     {
@@ -80,44 +48,44 @@ int main()
         {
             std::cerr << "Error: " << e.what() << '\n';
         }
-        graph.emplace_back(std::move(from), std::move(to), weight);
+        ends.emplace_back(std::move(from));
+        ends.emplace_back(std::move(to));
+        weights.emplace_back(weight);
     }
-    // std::cout << graph << "\n";
-    // sort edges
-    auto graphSorted(graph);
-    timSort(graphSorted.begin(), graphSorted.end());
-    // std::cout << graphSorted << "\n";
+    // names are only built once and read, sorted array is enough
+    NamesSet names(ends.begin(), ends.end(), std::less<std::string>(), alloc);
+    Graph graph(alloc);
+    graph.reserve(weights.size());
+    for (int i = 0; i < weights.size(); i++)
+        graph.emplace_back(names.index_of(ends[2 * i]), names.index_of(ends[2 * i + 1]), weights[i]);
 
-    // get array of names of tops
-    AVLTree<std::string> names;   
-    for (int i = 0; i < graphSorted.size(); i++)
-    {
-        names.insert(graphSorted[i].from);
-        names.insert(graphSorted[i].to);
-    }
-    DynArr<std::string> tops;
-    for (AVLTree<std::string>::left_root_right_iterator i = names.begin(); i != names.end(); i++)
-        tops.push_back(*i);
+    // sort edges, comparisons read only the array of weights
+    timSort(graph.begin(), graph.end(), EdgeWeightLess());
+    // std::cout << graph << "\n";
 
-    // std::cout << "tops: " << tops << "\n";
-    SetsSys setsSys(std::move(tops));
-    DynArr<Edge> treeTops;
-    for (int i = 0; i < graphSorted.size(); i++)
+    // spanning forest has less edges than tops
+    ArenaArr<unsigned int> treeEdges(alloc);
+    treeEdges.reserve(names.size());
+    SetsSys setsSys(names.extract());
+    for (int i = 0; i < graph.size(); i++)
     {
-        if (setsSys.findSet(graphSorted[i].from) != setsSys.findSet(graphSorted[i].to))
+        auto edge = graph[i];
+        if (setsSys.findSet(edge.from) != setsSys.findSet(edge.to))
         {
             // not cycle, adding this edge to tree
-            treeTops.push_back(graphSorted[i]);
-            setsSys.unionSets(graphSorted[i].from, graphSorted[i].to);
+            treeEdges.push_back(i);
+            setsSys.unionSets(edge.from, edge.to);
         }
     }
     
     // print output
     unsigned int weightSum = 0;
-    for (int i = 0; i < treeTops.size(); i++)
+    const auto& tops = setsSys.tops();
+    for (int i = 0; i < treeEdges.size(); i++)
     {
-        std::cout << treeTops[i].from << " " << treeTops[i].to << "\n";
-        weightSum += treeTops[i].weight;
+        auto edge = graph[treeEdges[i]];
+        std::cout << tops[edge.from] << " " << tops[edge.to] << "\n";
+        weightSum += edge.weight;
     }
     std::cout << weightSum;
 }
\ No newline at end of file
@@ -0,0 +1,129 @@
+#ifndef MAPPED_ALLOCATOR_HPP_INCLUDED
+#define MAPPED_ALLOCATOR_HPP_INCLUDED
+
+#include <memory>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+
+// allocator for big DynArr: blocks from mapThreshold bytes are mapped from
+// the OS directly, so they can be grown by mremap which moves pages instead
+// of copying bytes and does not hold old and new buffers at once.
+// smaller blocks (and all blocks on other systems) use global operator new
+// https://man7.org/linux/man-pages/man2/mremap.2.html
+template < typename T >
+class MappedAllocator
+{
+public:
+    typedef T value_type;
+    typedef value_type* pointer;
+    typedef const value_type* const_pointer;
+    typedef value_type& reference;
+    typedef const value_type& const_reference;
+    typedef std::size_t size_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef std::true_type is_always_equal;
+
+    static const size_type mapThreshold = 1 << 20;
+    static const size_type pageSize = 4096;
+
+    template < typename U >
+    struct rebind
+    {
+        typedef MappedAllocator<U> other;
+    };
+
+public:
+    MappedAllocator() noexcept
+    {}
+    MappedAllocator(const MappedAllocator& other) = default;
+    template < typename U >
+    MappedAllocator(const MappedAllocator<U>&) noexcept
+    {}
+
+    pointer allocate(size_type n)
+    {
+        auto bytes = n * sizeof(value_type);
+        if (!_isMapped(bytes))
+            return static_cast<pointer>(::operator new(bytes));
+
+#if defined(__linux__)
+        void* p = mmap(nullptr, _pages(bytes), PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED)
+            throw std::bad_alloc();
+
+        return static_cast<pointer>(p);
+#else
+        // not reached: blocks are mapped only on Linux
+        return static_cast<pointer>(::operator new(bytes));
+#endif
+    }
+
+    void deallocate(pointer p, size_type n) noexcept
+    {
+        auto bytes = n * sizeof(value_type);
+        if (!_isMapped(bytes))
+            ::operator delete(p);
+#if defined(__linux__)
+        else
+            munmap(p, _pages(bytes));
+#endif
+    }
+
+    // grows or shrinks mapped block keeping its bytes, nullptr if it is not mapped
+    // (old block is still valid then)
+    pointer reallocate(pointer p, size_type oldCount, size_type newCount) noexcept
+    {
+        auto oldBytes = oldCount * sizeof(value_type);
+        auto newBytes = newCount * sizeof(value_type);
+        if (!_isMapped(oldBytes) || !_isMapped(newBytes))
+            return nullptr;
+
+#if defined(__linux__)
+        void* newP = mremap(p, _pages(oldBytes), _pages(newBytes), MREMAP_MAYMOVE);
+        if (newP == MAP_FAILED)
+            return nullptr;
+
+        return static_cast<pointer>(newP);
+#else
+        (void)p;
+        return nullptr;
+#endif
+    }
+
+private:
+    static bool _isMapped(size_type bytes) noexcept
+    {
+#if defined(__linux__)
+        return bytes >= mapThreshold;
+#else
+        (void)bytes;
+        return false;
+#endif
+    }
+
+    static size_type _pages(size_type bytes) noexcept
+    {
+        return (bytes + pageSize - 1) / pageSize * pageSize;
+    }
+};
+
+template < typename T, typename U >
+bool operator==(const MappedAllocator<T>&, const MappedAllocator<U>&) noexcept
+{
+    return true;
+}
+template < typename T, typename U >
+bool operator!=(const MappedAllocator<T>&, const MappedAllocator<U>&) noexcept
+{
+    return false;
+}
+
+
+#endif // MAPPED_ALLOCATOR_HPP_INCLUDED
@@ -0,0 +1,533 @@
+#ifndef PERSISTENT_AVL_TREE_HPP_INCLUDED
+#define PERSISTENT_AVL_TREE_HPP_INCLUDED
+
+#include <functional>
+#include <memory>
+#include <cstddef>
+#include <iterator>
+#include <utility>
+#include <algorithm>
+
+#include "stack.hpp"
+
+//! persistent (versioned) AVL tree: insert and erase do not change the tree,
+//! they return a new version which shares all untouched nodes with the old one
+//! (only O(log n) nodes on the path to the changed key are copied)
+//! copy of a version takes O(1), nodes are deleted with the last version using them
+//! reference counters are not atomic, all versions must be used by one thread
+// https://en.wikipedia.org/wiki/Persistent_data_structure#Path_copying
+
+// node structure, nodes are never changed after building
+template < typename Key >
+struct PersistentTreeNode
+{
+    typedef Key value_type;
+    typedef PersistentTreeNode<value_type> node_type;
+    typedef node_type* node_pointer;
+
+    PersistentTreeNode(const value_type& value, node_pointer left, node_pointer right):
+        value(value), left(left), right(right), refs(1)
+    {
+        height = std::max(left == nullptr ? 0 : left->height, right == nullptr ? 0 : right->height) + 1;
+        count = (left == nullptr ? 0 : left->count) + (right == nullptr ? 0 : right->count) + 1;
+    }
+
+    value_type value;
+    node_pointer left;
+    node_pointer right;
+    std::size_t height;
+    std::size_t count; // number of nodes in subtree
+    std::size_t refs; // number of parents and versions which use this node
+};
+
+// height of AVL tree with less than 2^44 nodes is less than 64
+const static std::size_t persistentTreeMaxHeight = 64;
+
+// in-order iterator, it is valid while its version exists
+// https://en.cppreference.com/w/cpp/named_req/ForwardIterator
+template < typename Key >
+class PersistentTreeIterator
+{
+public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef Key value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef const value_type* pointer;
+    typedef const value_type* const_pointer;
+    typedef const value_type& reference;
+    typedef const value_type& const_reference;
+
+private:
+    typedef const PersistentTreeNode<Key>* node_pointer;
+
+template < typename Key1, typename Compare, typename Allocator >
+    friend class PersistentAVLTree;
+
+public:
+    PersistentTreeIterator()
+    {}
+    PersistentTreeIterator(const PersistentTreeIterator& other) = default;
+    PersistentTreeIterator& operator=(const PersistentTreeIterator& other) = default;
+
+    ~PersistentTreeIterator()
+    {}
+
+    reference operator*() const
+    {
+        return _path.top()->value;
+    }
+
+    pointer operator->() const
+    {
+        return &(_path.top()->value);
+    }
+
+    PersistentTreeIterator& operator++()
+    {
+        _goToNext();
+        return *this;
+    }
+    PersistentTreeIterator operator++(int)
+    {
+        PersistentTreeIterator oldIter(*this);
+        _goToNext();
+        return oldIter;
+    }
+
+    bool operator==(const PersistentTreeIterator& other) const
+    {
+        if (_path.empty() || other._path.empty())
+            return _path.empty() && other._path.empty();
+
+        return _path.top() == other._path.top();
+    }
+    bool operator!=(const PersistentTreeIterator& other) const
+    {
+        return !(*this == other);
+    }
+
+private:
+    // pushing n and its left descendants
+    void _goToFirst(node_pointer n)
+    {
+        for (; n != nullptr; n = n->left)
+            _path.push(n);
+    }
+
+    void _goToNext()
+    {
+        if (_path.empty())
+            return;
+
+        // path keeps only nodes which are not visited yet
+        auto n = _path.top();
+        _path.pop();
+        _goToFirst(n->right);
+    }
+
+private:
+    InlineStack<node_pointer, persistentTreeMaxHeight> _path;
+};
+
+template < typename Key, typename Compare = std::less<Key>, typename Allocator = std::allocator<Key> >
+class PersistentAVLTree
+{
+public:
+    typedef Key key_type;
+    typedef Key value_type;
+    typedef std::size_t size_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef Compare key_compare;
+    typedef Compare value_compare;
+    typedef Allocator allocator_type;
+    typedef value_type& reference;
+    typedef const value_type& const_reference;
+
+    typedef PersistentTreeIterator<Key> iterator;
+    typedef PersistentTreeIterator<Key> const_iterator;
+
+private:
+    template < typename Alloc >
+    using traits = std::allocator_traits<Alloc>;
+
+    typedef PersistentTreeNode<Key> node_type;
+    typedef typename Allocator::template rebind<node_type>::other NodeAllocator;
+    typedef typename traits<NodeAllocator>::pointer node_pointer;
+
+public:
+    PersistentAVLTree(): _root(nullptr)
+    {}
+    explicit PersistentAVLTree(const Compare& comp, const Allocator& alloc = Allocator()):
+        _root(nullptr), _cmp(comp), _nodeAlloc(alloc)
+    {}
+    explicit PersistentAVLTree(const Allocator& alloc):
+        _root(nullptr), _nodeAlloc(alloc)
+    {}
+    template < typename InputIt >
+    PersistentAVLTree(InputIt first, InputIt last,
+        const Compare& comp = Compare(),
+        const Allocator& alloc = Allocator()):
+        PersistentAVLTree(comp, alloc)
+    {
+        for (; first != last; first++)
+            *this = insert(*first);
+    }
+    // versions share all nodes
+    PersistentAVLTree(const PersistentAVLTree& other):
+        _root(_share(other._root)), _cmp(other._cmp), _nodeAlloc(other._nodeAlloc)
+    {}
+    PersistentAVLTree(PersistentAVLTree&& other):
+        _root(other._root), _cmp(other._cmp), _nodeAlloc(other._nodeAlloc)
+    {
+        other._root = nullptr;
+    }
+    PersistentAVLTree(std::initializer_list<value_type> init,
+        const Compare& comp = Compare(),
+        const Allocator& alloc = Allocator()):
+        PersistentAVLTree(init.begin(), init.end(), comp, alloc)
+    {}
+
+    ~PersistentAVLTree()
+    {
+        _release(_root);
+    }
+
+    PersistentAVLTree& operator=(const PersistentAVLTree& other)
+    {
+        if (this == &other)
+            return *this;
+
+        _release(_root);
+        _root = _share(other._root);
+        _cmp = other._cmp;
+        _nodeAlloc = other._nodeAlloc;
+        return *this;
+    }
+    PersistentAVLTree& operator=(PersistentAVLTree&& other)
+    {
+        if (this == &other)
+            return *this;
+
+        _release(_root);
+        _root = other._root;
+        _cmp = other._cmp;
+        _nodeAlloc = other._nodeAlloc;
+        other._root = nullptr;
+        return *this;
+    }
+
+    const_iterator begin() const
+    {
+        const_iterator iter;
+        iter._goToFirst(_root);
+        return iter;
+    }
+    const_iterator cbegin() const
+    {
+        return begin();
+    }
+
+    const_iterator end() const noexcept
+    {
+        return const_iterator();
+    }
+    const_iterator cend() const noexcept
+    {
+        return end();
+    }
+
+    bool empty() const noexcept
+    {
+        return _root == nullptr;
+    }
+    size_type size() const noexcept
+    {
+        return _getCount(_root);
+    }
+
+    allocator_type get_allocator() const noexcept
+    {
+        return allocator_type(_nodeAlloc);
+    }
+    key_compare key_comp() const
+    {
+        return _cmp;
+    }
+    value_compare value_comp() const
+    {
+        return _cmp;
+    }
+
+    // new version with value, the same version if value already exists
+    PersistentAVLTree insert(const value_type& value) const
+    {
+        bool inserted = false;
+        auto root = _insert(_root, value, inserted);
+        return inserted ? PersistentAVLTree(root, _cmp, _nodeAlloc) : *this;
+    }
+
+    // new version without key, the same version if there is no such key
+    PersistentAVLTree erase(const Key& key) const
+    {
+        bool erased = false;
+        auto root = _erase(_root, key, erased);
+        return erased ? PersistentAVLTree(root, _cmp, _nodeAlloc) : *this;
+    }
+
+    const_iterator find(const Key& key) const
+    {
+        // path keeps the nodes where we went left, they are visited after the found one
+        const_iterator iter;
+        for (auto i = _root; i != nullptr;)
+        {
+            if (_cmp(key, i->value))
+            {
+                iter._path.push(i);
+                i = i->left;
+            }
+            else if (_cmp(i->value, key))
+                i = i->right;
+            else
+            {
+                iter._path.push(i);
+                return iter;
+            }
+        }
+        return end();
+    }
+
+    bool contains(const Key& key) const
+    {
+        for (auto i = _root; i != nullptr;)
+        {
+            if (_cmp(key, i->value))
+                i = i->left;
+            else if (_cmp(i->value, key))
+                i = i->right;
+            else
+                return true;
+        }
+        return false;
+    }
+
+private:
+    // takes the reference to root
+    PersistentAVLTree(node_pointer root, const Compare& comp, const NodeAllocator& alloc):
+        _root(root), _cmp(comp), _nodeAlloc(alloc)
+    {}
+
+    static size_type _getHeight(node_pointer x) noexcept
+    {
+        return x == nullptr ? 0 : x->height;
+    }
+    static size_type _getCount(node_pointer x) noexcept
+    {
+        return x == nullptr ? 0 : x->count;
+    }
+
+    static node_pointer _share(node_pointer x) noexcept
+    {
+        if (x != nullptr)
+            x->refs++;
+
+        return x;
+    }
+    void _release(node_pointer x) const noexcept
+    {
+        if (x == nullptr || --x->refs != 0)
+            return;
+
+        _release(x->left);
+        _release(x->right);
+        traits<NodeAllocator>::destroy(_nodeAlloc, x);
+        traits<NodeAllocator>::deallocate(_nodeAlloc, x, 1);
+    }
+
+    // new node takes the references to left and right
+    node_pointer _createNode(const value_type& value, node_pointer left, node_pointer right) const
+    {
+        node_pointer nodeP;
+        try
+        {
+            nodeP = traits<NodeAllocator>::allocate(_nodeAlloc, 1);
+            try
+            {
+                traits<NodeAllocator>::construct(_nodeAlloc, nodeP, value, left, right);
+            }
+            catch(...)
+            {
+                traits<NodeAllocator>::deallocate(_nodeAlloc, nodeP, 1);
+                throw;
+            }
+        }
+        catch(...)
+        {
+            _release(left);
+            _release(right);
+            throw;
+        }
+        return nodeP;
+    }
+
+    // functions below take nodes of old version and return references to new subtrees
+
+    // node with value of n and given children, the AVL balance is restored by rotations;
+    // inner nodes are made first, so on exception every taken reference is released
+    node_pointer _balance(node_pointer n, node_pointer left, node_pointer right) const
+    {
+        if (_getHeight(left) > _getHeight(right) + 1)
+        {
+            // left is a new node, its children are shared
+            node_pointer root;
+            try
+            {
+                if (_getHeight(left->left) >= _getHeight(left->right))
+                {
+                    // right rotation
+                    auto newRight = _createNode(n->value, _share(left->right), right);
+                    root = _createNode(left->value, _share(left->left), newRight);
+                }
+                else
+                {
+                    // left right rotation
+                    auto mid = left->right;
+                    auto newRight = _createNode(n->value, _share(mid->right), right);
+                    node_pointer newLeft;
+                    try
+                    {
+                        newLeft = _createNode(left->value, _share(left->left), _share(mid->left));
+                    }
+                    catch(...)
+                    {
+                        _release(newRight);
+                        throw;
+                    }
+                    root = _createNode(mid->value, newLeft, newRight);
+                }
+            }
+            catch(...)
+            {
+                _release(left);
+                throw;
+            }
+            _release(left);
+            return root;
+        }
+        if (_getHeight(right) > _getHeight(left) + 1)
+        {
+            node_pointer root;
+            try
+            {
+                if (_getHeight(right->right) >= _getHeight(right->left))
+                {
+                    // left rotation
+                    auto newLeft = _createNode(n->value, left, _share(right->left));
+                    root = _createNode(right->value, newLeft, _share(right->right));
+                }
+                else
+                {
+                    // right left rotation
+                    auto mid = right->left;
+                    auto newLeft = _createNode(n->value, left, _share(mid->left));
+                    node_pointer newRight;
+                    try
+                    {
+                        newRight = _createNode(right->value, _share(mid->right), _share(right->right));
+                    }
+                    catch(...)
+                    {
+                        _release(newLeft);
+                        throw;
+                    }
+                    root = _createNode(mid->value, newLeft, newRight);
+                }
+            }
+            catch(...)
+            {
+                _release(right);
+                throw;
+            }
+            _release(right);
+            return root;
+        }
+        return _createNode(n->value, left, right);
+    }
+
+    node_pointer _insert(node_pointer root, const value_type& value, bool& inserted) const
+    {
+        if (root == nullptr)
+        {
+            inserted = true;
+            return _createNode(value, nullptr, nullptr);
+        }
+        if (_cmp(value, root->value))
+        {
+            auto left = _insert(root->left, value, inserted);
+            if (!inserted)
+                return nullptr;
+
+            return _balance(root, left, _share(root->right));
+        }
+        if (_cmp(root->value, value))
+        {
+            auto right = _insert(root->right, value, inserted);
+            if (!inserted)
+                return nullptr;
+
+            return _balance(root, _share(root->left), right);
+        }
+        // this value already exists
+        return nullptr;
+    }
+
+    // subtree without its smallest node, which is returned in min
+    node_pointer _eraseMin(node_pointer root, node_pointer& min) const
+    {
+        if (root->left == nullptr)
+        {
+            min = root;
+            return _share(root->right);
+        }
+        auto left = _eraseMin(root->left, min);
+        return _balance(root, left, _share(root->right));
+    }
+
+    node_pointer _erase(node_pointer root, const Key& key, bool& erased) const
+    {
+        if (root == nullptr)
+            // there is no such key
+            return nullptr;
+
+        if (_cmp(key, root->value))
+        {
+            auto left = _erase(root->left, key, erased);
+            if (!erased)
+                return nullptr;
+
+            return _balance(root, left, _share(root->right));
+        }
+        if (_cmp(root->value, key))
+        {
+            auto right = _erase(root->right, key, erased);
+            if (!erased)
+                return nullptr;
+
+            return _balance(root, _share(root->left), right);
+        }
+        erased = true;
+        if (root->left == nullptr || root->right == nullptr)
+            return _share(root->left != nullptr ? root->left : root->right);
+
+        // nearest greater key takes place of root
+        node_pointer min;
+        auto right = _eraseMin(root->right, min);
+        return _balance(min, _share(root->left), right);
+    }
+
+private:
+    node_pointer _root;
+    Compare _cmp;
+    mutable NodeAllocator _nodeAlloc; // new versions are made by const functions
+};
+
+#endif // PERSISTENT_AVL_TREE_HPP_INCLUDED
@@ -0,0 +1,433 @@
+#ifndef SEGMENTED_ARRAY_HPP_INCLUDED
+#define SEGMENTED_ARRAY_HPP_INCLUDED
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <cstddef>
+#include <iterator>
+#include <utility>
+
+#include "dynamic_array.hpp"
+
+//! array of fixed-size blocks with the interface of DynArr:
+//! it grows by adding a block, elements are never moved, so
+//! references and pointers to them stay valid until the element
+//! is removed, and push_back has no O(n) copy at any size.
+//! only the table of block pointers is reallocated (BlockSize
+//! times smaller than the elements)
+
+// https://en.cppreference.com/w/cpp/container/deque
+template < typename T, typename Blocks, std::size_t BlockSize >
+class SegmentedIterator
+{
+public:
+    typedef std::random_access_iterator_tag iterator_category;
+    typedef T value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef std::size_t size_type;
+    typedef value_type* pointer;
+    typedef value_type& reference;
+
+template < typename T1, typename Allocator, std::size_t BlockSize1 >
+    friend class SegmentedArr;
+
+template < typename T1, typename Blocks1, std::size_t BlockSize1 >
+    friend class SegmentedIterator;
+
+private:
+    SegmentedIterator(const Blocks* blocks, size_type pos): _blocks(blocks), _pos(pos)
+    {}
+
+public:
+    SegmentedIterator(): _blocks(nullptr), _pos(0)
+    {}
+    SegmentedIterator(const SegmentedIterator& other) = default;
+    SegmentedIterator& operator=(const SegmentedIterator& other) = default;
+
+    ~SegmentedIterator()
+    {}
+
+    // iterator keeps the position, so it stays valid when blocks are added
+    reference operator*() const
+    {
+        return (*_blocks)[_pos / BlockSize][_pos % BlockSize];
+    }
+
+    pointer operator->() const
+    {
+        return &**this;
+    }
+
+    reference operator[](difference_type n) const
+    {
+        return *(*this + n);
+    }
+
+    SegmentedIterator& operator++()
+    {
+        _pos++;
+        return *this;
+    }
+    SegmentedIterator operator++(int)
+    {
+        SegmentedIterator oldIter(*this);
+        _pos++;
+        return oldIter;
+    }
+
+    SegmentedIterator& operator--()
+    {
+        _pos--;
+        return *this;
+    }
+    SegmentedIterator operator--(int)
+    {
+        SegmentedIterator oldIter(*this);
+        _pos--;
+        return oldIter;
+    }
+
+    SegmentedIterator& operator+=(difference_type n)
+    {
+        _pos += n;
+        return *this;
+    }
+    SegmentedIterator& operator-=(difference_type n)
+    {
+        return *this += -n;
+    }
+    SegmentedIterator operator+(difference_type n) const
+    {
+        SegmentedIterator it = *this;
+        return it += n;
+    }
+    SegmentedIterator operator-(difference_type n) const
+    {
+        return *this + (-n);
+    }
+
+    difference_type operator-(const SegmentedIterator& other) const
+    {
+        return (difference_type)_pos - (difference_type)other._pos;
+    }
+
+    bool operator==(const SegmentedIterator& other) const
+    {
+        return _pos == other._pos;
+    }
+    bool operator!=(const SegmentedIterator& other) const
+    {
+        return !(*this == other);
+    }
+    bool operator<(const SegmentedIterator& other) const
+    {
+        return _pos < other._pos;
+    }
+    bool operator>(const SegmentedIterator& other) const
+    {
+        return other < *this;
+    }
+    bool operator<=(const SegmentedIterator& other) const
+    {
+        return !(other < *this);
+    }
+    bool operator>=(const SegmentedIterator& other) const
+    {
+        return !(*this < other);
+    }
+
+    operator SegmentedIterator<const value_type, Blocks, BlockSize>() const noexcept
+    {
+        return SegmentedIterator<const value_type, Blocks, BlockSize>(_blocks, _pos);
+    }
+
+private:
+    const Blocks* _blocks;
+    size_type _pos;
+};
+
+template < typename T, typename Allocator = std::allocator<T>, std::size_t BlockSize = 1024 >
+class SegmentedArr
+{
+    static_assert(BlockSize != 0 && (BlockSize & (BlockSize - 1)) == 0,
+        "SegmentedArr: BlockSize must be a power of 2");
+
+public:
+    // member types
+    typedef T value_type;
+    typedef Allocator allocator_type;
+    typedef std::size_t size_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef value_type& reference;
+    typedef const value_type& const_reference;
+    typedef typename std::allocator_traits<Allocator>::pointer pointer;
+    typedef typename std::allocator_traits<Allocator>::const_pointer const_pointer;
+
+private:
+    template < typename Alloc >
+    using traits = std::allocator_traits<Alloc>;
+    typedef typename Allocator::template rebind<pointer>::other BlockPointerAllocator;
+    typedef DynArr<pointer, BlockPointerAllocator> blocks_type;
+
+public:
+    typedef SegmentedIterator<value_type, blocks_type, BlockSize> iterator;
+    typedef SegmentedIterator<const value_type, blocks_type, BlockSize> const_iterator;
+
+public:
+    // member functions
+    SegmentedArr(): _size(0)
+    {}
+
+    explicit SegmentedArr(const Allocator& alloc):
+            _blocks(BlockPointerAllocator(alloc)), _size(0), _alloc(alloc)
+    {}
+
+    SegmentedArr(size_type count, const T& value, const Allocator& alloc = Allocator()):
+            SegmentedArr(alloc)
+    {
+        reserve(count);
+        for (size_type i = 0; i < count; i++)
+            push_back(value);
+    }
+
+    explicit SegmentedArr(size_type count, const Allocator& alloc = Allocator()):
+            SegmentedArr(alloc)
+    {
+        reserve(count);
+        for (size_type i = 0; i < count; i++)
+            emplace_back();
+    }
+
+    SegmentedArr(const SegmentedArr& other):
+            SegmentedArr(traits<Allocator>::select_on_container_copy_construction(other._alloc))
+    {
+        reserve(other.size());
+        for (size_type i = 0; i < other.size(); i++)
+            push_back(other[i]);
+    }
+
+    SegmentedArr(SegmentedArr&& other) noexcept:
+            _blocks(std::move(other._blocks)), _size(other._size), _alloc(other._alloc)
+    {
+        // taking the blocks of other
+        other._size = 0;
+    }
+
+    SegmentedArr(std::initializer_list<T> init, const Allocator& alloc = Allocator()):
+            SegmentedArr(alloc)
+    {
+        reserve(init.size());
+        for (auto i = init.begin(); i != init.end(); i++)
+            push_back(*i);
+    }
+
+    // DynArr of blocks can not be assigned
+    SegmentedArr& operator=(const SegmentedArr& other) = delete;
+    SegmentedArr& operator=(SegmentedArr&& other) = delete;
+
+    ~SegmentedArr()
+    {
+        clear();
+    }
+
+    // element access
+    reference at(size_type pos)
+    {
+        if (!(pos < size()))
+            throw std::out_of_range(std::string("SegmentedArr::at: pos >= this.size() (which is ") +
+                    std::to_string(size()) + ")");
+
+        return (*this)[pos];
+    }
+    const_reference at(size_type pos) const
+    {
+        if (!(pos < size()))
+            throw std::out_of_range(std::string("SegmentedArr::at: pos >= this.size() (which is ") +
+                    std::to_string(size()) + ")");
+
+        return (*this)[pos];
+    }
+
+    reference operator[](size_type pos)
+    {
+        return _blocks[pos / BlockSize][pos % BlockSize];
+    }
+    const_reference operator[](size_type pos) const
+    {
+        return _blocks[pos / BlockSize][pos % BlockSize];
+    }
+
+    reference front()
+    {
+        return (*this)[0];
+    }
+    const_reference front() const
+    {
+        return (*this)[0];
+    }
+
+    reference back()
+    {
+        return (*this)[size() - 1];
+    }
+    const_reference back() const
+    {
+        return (*this)[size() - 1];
+    }
+
+    allocator_type get_allocator() const noexcept
+    {
+        return _alloc;
+    }
+
+    // iterators
+    iterator begin() noexcept
+    {
+        return iterator(&_blocks, 0);
+    }
+    const_iterator begin() const noexcept
+    {
+        return const_iterator(&_blocks, 0);
+    }
+    const_iterator cbegin() const noexcept
+    {
+        return const_iterator(&_blocks, 0);
+    }
+
+    iterator end() noexcept
+    {
+        return iterator(&_blocks, size());
+    }
+    const_iterator end() const noexcept
+    {
+        return const_iterator(&_blocks, size());
+    }
+    const_iterator cend() const noexcept
+    {
+        return const_iterator(&_blocks, size());
+    }
+
+    // capasity
+    bool empty() const noexcept
+    {
+        return size() == 0;
+    }
+
+    size_type size() const noexcept
+    {
+        return _size;
+    }
+
+    size_type capacity() const noexcept
+    {
+        return _blocks.size() * BlockSize;
+    }
+
+    void reserve(size_type newCap)
+    {
+        _blocks.reserve((newCap + BlockSize - 1) / BlockSize);
+        for (; capacity() < newCap;)
+            _addBlock();
+    }
+
+    // gives back blocks without elements
+    void shrink_to_fit()
+    {
+        auto used = (size() + BlockSize - 1) / BlockSize;
+        for (; _blocks.size() > used;)
+        {
+            traits<Allocator>::deallocate(_alloc, _blocks.back(), BlockSize);
+            _blocks.pop_back();
+        }
+        _blocks.shrink_to_fit();
+    }
+
+    // modifiers
+    void clear() noexcept
+    {
+        resize(0);
+        shrink_to_fit();
+    }
+
+    void push_back(const T& value)
+    {
+        emplace_back(value);
+    }
+
+    void push_back(T&& value)
+    {
+        emplace_back(std::move(value));
+    }
+
+    // elements are not moved, so args may refer to them
+    template < typename... Args >
+        reference emplace_back(Args&&... args)
+        {
+            if (size() == capacity())
+                _addBlock();
+
+            traits<Allocator>::construct(_alloc, &(*this)[size()], std::forward<Args>(args)...);
+            _size++;
+            return back();
+        }
+
+    void pop_back()
+    {
+        resize(size() - 1);
+    }
+
+    void resize(size_type count)
+    {
+        if (!(count <= size()))
+            throw std::out_of_range(std::string("SegmentedArr::resize: count > this.size() (which is ") +
+                    std::to_string(size()) + ")");
+
+        for (; size() > count;)
+            traits<Allocator>::destroy(_alloc, &(*this)[--_size]);
+    }
+
+    void resize(size_type count, const T& val)
+    {
+        if (count < size())
+            resize(count);
+        else
+            for (; size() < count;)
+                push_back(val);
+    }
+
+private:
+    void _addBlock()
+    {
+        auto block = traits<Allocator>::allocate(_alloc, BlockSize);
+        try
+        {
+            _blocks.push_back(block);
+        }
+        catch(...)
+        {
+            traits<Allocator>::deallocate(_alloc, block, BlockSize);
+            throw;
+        }
+    }
+
+private:
+    // fields
+    blocks_type _blocks;
+    size_type _size;
+    Allocator _alloc;
+};
+
+// non-member functions
+template < typename T, typename Alloc, std::size_t BlockSize >
+std::ostream& operator<<(std::ostream& os, const SegmentedArr<T, Alloc, BlockSize>& arr)
+{
+    os << "[";
+    for (std::size_t i = 0; i < arr.size(); i++)
+        os << (i == 0 ? "" : ", ") << arr[i];
+    os << "]";
+    return os;
+}
+
+
+#endif // SEGMENTED_ARRAY_HPP_INCLUDED
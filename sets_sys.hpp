@@ -2,61 +2,57 @@
 #define SETS_SYS_HPP_INCLUDED
 
 #include <iostream>
+#include <string>
 
 #include "dynamic_array.hpp"
 
+template < typename Allocator = std::allocator<std::string> >
 class SetsSys
 {
+    typedef typename Allocator::template rebind<unsigned int>::other IndexAllocator;
+
 public:
-    SetsSys(DynArr<std::string>&& tops): _tops(std::move(tops)), _indexes(_tops.size())
+    // sets are given by indexes of tops, names are resolved by the caller
+    // (e.g. by FlatSet::index_of before the tops are extracted)
+    SetsSys(DynArr<std::string, Allocator>&& tops): 
+        _tops(std::move(tops)),
+        _indexes(_tops.size(), IndexAllocator(_tops.get_allocator()))
     {
         for (unsigned int i = 0; i < _indexes.size(); i++)
             _indexes[i] = i;
     }
-    bool unionSets(const std::string& set, const std::string& x)
+
+    bool unionSets(unsigned int indexSet, unsigned int indexX)
     {
-        int indexSet = -1, indexX = -1;
-        for (int i = 0; i < _tops.size(); i++)
-        {
-            if (_tops[i] == set)
-                indexSet = i;
-            if (_tops[i] == x)
-                indexX = i;
-        }
-        if (indexSet == -1 || indexX == -1)
+        if (indexSet >= _tops.size() || indexX >= _tops.size())
             return false;
 
-        for (; indexX != _indexes[indexX];)
-            indexX = _indexes[indexX];
-        
-        for (; indexSet != _indexes[indexSet];)
-            indexSet = _indexes[indexSet];
-        
-        _indexes[indexX] = _indexes[indexSet];
+        _indexes[findSet(indexX)] = findSet(indexSet);
         return true;
     }
-    std::string findSet(const std::string& x) const
+    unsigned int findSet(unsigned int indexX) const
     {
-        int indexX = -1;
-        for (int i = 0; i < _tops.size(); i++)
-        {
-            if (_tops[i] == x)
-                indexX = i;
-        }
         for (; indexX != _indexes[indexX];)
             indexX = _indexes[indexX];
 
-        return _tops[indexX];
+        return indexX;
+    }
+
+    const DynArr<std::string, Allocator>& tops() const noexcept
+    {
+        return _tops;
     }
 
-friend std::ostream& operator<<(std::ostream&, const SetsSys&);
+template < typename Alloc >
+    friend std::ostream& operator<<(std::ostream&, const SetsSys<Alloc>&);
 
 private:
-    DynArr<std::string> _tops;
-    DynArr<unsigned int> _indexes;
+    DynArr<std::string, Allocator> _tops;
+    DynArr<unsigned int, IndexAllocator> _indexes;
 };
 
-std::ostream& operator<<(std::ostream& os, const SetsSys& setsSys)
+template < typename Allocator >
+std::ostream& operator<<(std::ostream& os, const SetsSys<Allocator>& setsSys)
 {
     for (int i = 0; i < setsSys._tops.size(); i++)
         os << setsSys._tops[i] << " " << setsSys._indexes[i] << "\n";
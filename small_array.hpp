@@ -0,0 +1,442 @@
+#ifndef SMALL_ARRAY_HPP_INCLUDED
+#define SMALL_ARRAY_HPP_INCLUDED
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <utility>
+#include <type_traits>
+
+#include "dynamic_array.hpp"
+
+//! DynArr with inline capacity: up to N elements are stored in the
+//! object itself, the heap is used only when the array gets bigger.
+//! moving an array with inline elements moves the elements one by one
+
+// https://llvm.org/doxygen/classllvm_1_1SmallVector.html
+template < typename T, std::size_t N, typename Allocator = std::allocator<T> >
+class SmallArr
+{
+    static_assert(N != 0, "SmallArr: inline capacity must not be 0");
+
+public:
+    // member types
+    typedef T value_type;
+    typedef Allocator allocator_type;
+    typedef std::size_t size_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef value_type& reference;
+    typedef const value_type& const_reference;
+    typedef typename std::allocator_traits<Allocator>::pointer pointer;
+    typedef typename std::allocator_traits<Allocator>::const_pointer const_pointer;
+    typedef RandomAccessIterator<value_type> iterator;
+    typedef RandomAccessIterator<const value_type> const_iterator;
+
+    static const size_type inline_capacity = N;
+
+private:
+    template < typename Alloc >
+    using traits = std::allocator_traits<Alloc>;
+
+public:
+    // member functions
+    SmallArr() noexcept(noexcept(Allocator())):
+            _p(_inlineData()), _size(0), _cap(N), _alloc(Allocator())
+    {}
+
+    explicit SmallArr(const Allocator& alloc):
+            _p(_inlineData()), _size(0), _cap(N),
+            _alloc(traits<Allocator>::select_on_container_copy_construction(alloc))
+    {}
+
+    SmallArr(size_type count, const T& value, const Allocator& alloc = Allocator()):
+            SmallArr(alloc)
+    {
+        reserve(count);
+        for (size_type i = 0; i < count; i++)
+            push_back(value);
+    }
+
+    explicit SmallArr(size_type count, const Allocator& alloc = Allocator()):
+            SmallArr(alloc)
+    {
+        reserve(count);
+        for (size_type i = 0; i < count; i++)
+            emplace_back();
+    }
+
+    SmallArr(const SmallArr& other): SmallArr(other.get_allocator())
+    {
+        reserve(other.size());
+        for (size_type i = 0; i < other.size(); i++)
+            push_back(other[i]);
+    }
+
+    SmallArr(SmallArr&& other) noexcept(std::is_nothrow_move_constructible<T>::value):
+            SmallArr(other._alloc)
+    {
+        _takeElements(other);
+    }
+
+    SmallArr(std::initializer_list<T> init, const Allocator& alloc = Allocator()):
+            SmallArr(alloc)
+    {
+        reserve(init.size());
+        for (auto i = init.begin(); i != init.end(); i++)
+            push_back(*i);
+    }
+
+    SmallArr& operator=(const SmallArr& other)
+    {
+        if (this == &other)
+            return *this;
+
+        resize(0);
+        reserve(other.size());
+        for (size_type i = 0; i < other.size(); i++)
+            push_back(other[i]);
+
+        return *this;
+    }
+
+    SmallArr& operator=(SmallArr&& other)
+    {
+        if (this == &other)
+            return *this;
+
+        clear();
+        _alloc = other._alloc;
+        _takeElements(other);
+        return *this;
+    }
+
+    ~SmallArr()
+    {
+        clear();
+    }
+
+    // element access
+    reference at(size_type pos)
+    {
+        if (!(pos < size()))
+            throw std::out_of_range(std::string("SmallArr::at: pos >= this.size() (which is ") +
+                    std::to_string(size()) + ")");
+
+        return _p[pos];
+    }
+    const_reference at(size_type pos) const
+    {
+        if (!(pos < size()))
+            throw std::out_of_range(std::string("SmallArr::at: pos >= this.size() (which is ") +
+                    std::to_string(size()) + ")");
+
+        return _p[pos];
+    }
+
+    reference operator[](size_type pos)
+    {
+        return _p[pos];
+    }
+    const_reference operator[](size_type pos) const
+    {
+        return _p[pos];
+    }
+
+    reference front()
+    {
+        return _p[0];
+    }
+    const_reference front() const
+    {
+        return _p[0];
+    }
+
+    reference back()
+    {
+        return _p[size() - 1];
+    }
+    const_reference back() const
+    {
+        return _p[size() - 1];
+    }
+
+    allocator_type get_allocator() const noexcept
+    {
+        return _alloc;
+    }
+
+    // iterators
+    iterator begin() noexcept
+    {
+        return iterator(_p);
+    }
+    const_iterator begin() const noexcept
+    {
+        return const_iterator(_p);
+    }
+    const_iterator cbegin() const noexcept
+    {
+        return const_iterator(_p);
+    }
+
+    iterator end() noexcept
+    {
+        return iterator(_p + size());
+    }
+    const_iterator end() const noexcept
+    {
+        return const_iterator(_p + size());
+    }
+    const_iterator cend() const noexcept
+    {
+        return const_iterator(_p + size());
+    }
+
+    // capasity
+    bool empty() const noexcept
+    {
+        return size() == 0;
+    }
+
+    size_type size() const noexcept
+    {
+        return _size;
+    }
+
+    size_type capacity() const noexcept
+    {
+        return _cap;
+    }
+
+    // elements are in the object itself, not on the heap
+    bool is_inline() const noexcept
+    {
+        return _p == _inlineData();
+    }
+
+    void reserve(size_type newCap)
+    {
+        if (newCap > capacity())
+            _reallocate(newCap);
+    }
+
+    // elements go back inline if they fit there
+    void shrink_to_fit()
+    {
+        if (!is_inline() && size() < capacity())
+            _reallocate(size());
+    }
+
+    // modifiers
+    void clear() noexcept
+    {
+        resize(0);
+        if (!is_inline())
+            traits<Allocator>::deallocate(_alloc, _p, capacity());
+        _p = _inlineData();
+        _cap = N;
+    }
+
+    void push_back(const T& value)
+    {
+        emplace_back(value);
+    }
+
+    void push_back(T&& value)
+    {
+        emplace_back(std::move(value));
+    }
+
+    template < typename... Args >
+        reference emplace_back(Args&&... args)
+        {
+            if (size() < capacity())
+            {
+                traits<Allocator>::construct(_alloc, _p + size(), std::forward<Args>(args)...);
+                _size++;
+                return back();
+            }
+            // args may refer to elements of this array, so they are used before moving
+            auto newCap = DoublingGrowth::grow(capacity(), size() + 1, sizeof(value_type));
+            auto newP = traits<Allocator>::allocate(_alloc, newCap);
+            try
+            {
+                traits<Allocator>::construct(_alloc, newP + size(), std::forward<Args>(args)...);
+            }
+            catch(...)
+            {
+                traits<Allocator>::deallocate(_alloc, newP, newCap);
+                throw;
+            }
+            try
+            {
+                _moveTo(newP, newCap);
+            }
+            catch(...)
+            {
+                traits<Allocator>::destroy(_alloc, newP + size());
+                traits<Allocator>::deallocate(_alloc, newP, newCap);
+                throw;
+            }
+            _size++;
+            return back();
+        }
+
+    void pop_back()
+    {
+        if (empty())
+            throw std::out_of_range(std::string("SmallArr::pop_back: this.size() is 0"));
+
+        traits<Allocator>::destroy(_alloc, _p + size() - 1);
+        _size--;
+    }
+
+    // new elements are value-initialized, array of type without
+    // default constructor can only be shrinked
+    void resize(size_type count)
+    {
+        if (count <= size())
+        {
+            for (size_type i = count; i < size(); i++)
+                traits<Allocator>::destroy(_alloc, _p + i);
+
+            _size = count;
+            return;
+        }
+        if constexpr (!std::is_default_constructible<T>::value)
+            throw std::out_of_range(std::string("SmallArr::resize: count > this.size() (which is ") +
+                    std::to_string(size()) + ")");
+        else
+        {
+            if (count > capacity())
+                _reallocate(DoublingGrowth::grow(capacity(), count, sizeof(value_type)));
+
+            auto oldSize = size();
+            try
+            {
+                for (; size() < count; _size++)
+                    traits<Allocator>::construct(_alloc, _p + size());
+            }
+            catch(...)
+            {
+                resize(oldSize);
+                throw;
+            }
+        }
+    }
+
+    void resize(size_type count, const T& val)
+    {
+        if (count < size())
+            resize(count);
+        else
+            for (; size() < count;)
+                push_back(val);
+    }
+
+private:
+    pointer _inlineData() noexcept
+    {
+        return reinterpret_cast<pointer>(&_inline);
+    }
+    const_pointer _inlineData() const noexcept
+    {
+        return reinterpret_cast<const_pointer>(&_inline);
+    }
+
+    // heap memory of other is taken, inline elements are moved
+    void _takeElements(SmallArr& other)
+    {
+        if (!other.is_inline())
+        {
+            _p = other._p;
+            _cap = other._cap;
+            _size = other._size;
+            other._p = other._inlineData();
+            other._cap = N;
+            other._size = 0;
+            return;
+        }
+        for (size_type i = 0; i < other.size(); i++)
+            push_back(std::move(other[i]));
+
+        other.resize(0);
+    }
+
+    // capacity not more than N means going back inline
+    void _reallocate(size_type newCap)
+    {
+        if (newCap <= N)
+        {
+            if (!is_inline())
+                _moveTo(_inlineData(), N);
+            return;
+        }
+        auto newP = traits<Allocator>::allocate(_alloc, newCap);
+        try
+        {
+            _moveTo(newP, newCap);
+        }
+        catch(...)
+        {
+            traits<Allocator>::deallocate(_alloc, newP, newCap);
+            throw;
+        }
+    }
+
+    // on exception this array is not changed, newP is left empty
+    void _moveTo(pointer newP, size_type newCap)
+    {
+        if (is_trivially_relocatable<T>::value)
+        {
+            if (size() != 0)
+                std::memcpy((void*)newP, (const void*)_p, size() * sizeof(value_type));
+        }
+        else
+        {
+            size_type i = 0;
+            try
+            {
+                for (; i < size(); i++)
+                    traits<Allocator>::construct(_alloc, newP + i, std::move_if_noexcept(_p[i]));
+            }
+            catch(...)
+            {
+                for (size_type j = 0; j < i; j++)
+                    traits<Allocator>::destroy(_alloc, newP + j);
+                throw;
+            }
+            for (i = 0; i < size(); i++)
+                traits<Allocator>::destroy(_alloc, _p + i);
+        }
+        if (!is_inline())
+            traits<Allocator>::deallocate(_alloc, _p, capacity());
+        _p = newP;
+        _cap = newCap;
+    }
+
+private:
+    // fields
+    pointer _p;
+    size_type _size;
+    size_type _cap;
+    Allocator _alloc;
+    typename std::aligned_storage<sizeof(T) * N, alignof(T)>::type _inline;
+};
+
+// non-member functions
+template < typename T, std::size_t N, typename Alloc >
+std::ostream& operator<<(std::ostream& os, const SmallArr<T, N, Alloc>& arr)
+{
+    os << "[";
+    for (std::size_t i = 0; i < arr.size(); i++)
+        os << (i == 0 ? "" : ", ") << arr[i];
+    os << "]";
+    return os;
+}
+
+
+#endif // SMALL_ARRAY_HPP_INCLUDED
@@ -1,11 +1,16 @@
+#ifndef TIM_SORT_HPP_INCLUDED
+#define TIM_SORT_HPP_INCLUDED
+
 #include <iostream>
 #include <algorithm>
+#include <functional>
 #include <type_traits>
 #include <iterator>
 #include <stdexcept>
 
 #include "stack.hpp"
 #include "dynamic_array.hpp"
+#include "small_array.hpp"
 
 template < typename T1, typename T2 >
 struct Pair
@@ -75,8 +80,8 @@ inline long long getMinrun(size_t n)
 }
 
 // https://ru.wikipedia.org/wiki/Сортировка_вставками
-template < typename BidirectionalIterator >
-void InsertionSort(const BidirectionalIterator begin, const BidirectionalIterator end)
+template < typename BidirectionalIterator, typename Compare >
+void InsertionSort(const BidirectionalIterator begin, const BidirectionalIterator end, Compare cmp)
 {
     if (begin == end)
         return;
@@ -86,14 +91,15 @@ void InsertionSort(const BidirectionalIterator begin, const BidirectionalIterato
     for (; curP != end; curP++)
     {
         bool isBeg = false;
-        auto val = *curP;
+        // value_type, not auto: reference of iterator may be proxy (EdgeRef)
+        typename std::iterator_traits<BidirectionalIterator>::value_type val = std::move(*curP);
         auto beforeP = curP;
         beforeP--;
-        for (; *beforeP > val;)
+        for (; cmp(val, *beforeP);)
         {
             auto k = beforeP;
             k++;
-            *k = *beforeP;
+            *k = std::move(*beforeP);
             if (beforeP != begin)
                 beforeP--;
             else
@@ -106,38 +112,52 @@ void InsertionSort(const BidirectionalIterator begin, const BidirectionalIterato
         if (!isBeg)
             insertP++;
 
-        *insertP = val;
+        *insertP = std::move(val);
     }
 }
 
+// temporary array for merging: runs up to 4 KB do not use heap
+template < typename T >
+using MergeBuffer = SmallArr<T, (4096 + sizeof(T) - 1) / sizeof(T)>;
+
 // https://ru.wikipedia.org/wiki/Timsort
+// elements are compared only by cmp (std::less by default)
 template < typename BidirectionalIterator >
 void timSort(const BidirectionalIterator begin, const BidirectionalIterator end);
-template < typename BidirectionalIterator >
+template < typename BidirectionalIterator, typename Compare >
+void timSort(const BidirectionalIterator begin, const BidirectionalIterator end, Compare cmp);
+template < typename BidirectionalIterator, typename Compare >
 Stack<Pair<BidirectionalIterator, size_t>> splitAndSort(const BidirectionalIterator begin, 
-    const BidirectionalIterator end);
-template < typename BidirectionalIterator >
+    const BidirectionalIterator end, Compare cmp);
+template < typename BidirectionalIterator, typename Compare >
 void mergeAll(Stack<Pair<BidirectionalIterator, size_t>>, const BidirectionalIterator begin, 
-    const BidirectionalIterator end);
-template < typename BidirectionalIterator >
+    const BidirectionalIterator end, Compare cmp);
+template < typename BidirectionalIterator, typename Compare >
 Pair<BidirectionalIterator, size_t> mergeWithoutGallop(Pair<BidirectionalIterator, size_t> left, 
-    Pair<BidirectionalIterator, size_t> right);
-template < typename RandomAccessIterator >
+    Pair<BidirectionalIterator, size_t> right, Compare cmp);
+template < typename RandomAccessIterator, typename Compare >
 Pair<RandomAccessIterator, size_t> merge(Pair<RandomAccessIterator, size_t> left, 
-    Pair<RandomAccessIterator, size_t> right);
+    Pair<RandomAccessIterator, size_t> right, Compare cmp);
 
 template < typename BidirectionalIterator >
 void timSort(const BidirectionalIterator begin, const BidirectionalIterator end)
 {
-    mergeAll(splitAndSort(begin, end), begin, end);
+    timSort(begin, end, std::less<>());
 }
 
-template < typename BidirectionalIterator >
+template < typename BidirectionalIterator, typename Compare >
+void timSort(const BidirectionalIterator begin, const BidirectionalIterator end, Compare cmp)
+{
+    mergeAll(splitAndSort(begin, end, cmp), begin, end, cmp);
+}
+
+template < typename BidirectionalIterator, typename Compare >
 Stack<Pair<BidirectionalIterator, size_t>> splitAndSort(const BidirectionalIterator begin, 
-    const BidirectionalIterator end)
+    const BidirectionalIterator end, Compare cmp)
 {
     Stack<Pair<BidirectionalIterator, size_t>> subs;
-    auto minRun = getMinrun(std::distance(begin, end));
+    auto minRun = (typename std::iterator_traits<BidirectionalIterator>::difference_type)
+        getMinrun(std::distance(begin, end));
     auto size = std::distance(begin, end);
 
     // Проверяем на размер 0 или 1
@@ -160,20 +180,17 @@ Stack<Pair<BidirectionalIterator, size_t>> splitAndSort(const BidirectionalItera
         auto p = subBeginP;
         p++;
         for (; p != end; p++)
-            if (*p != *subBeginP)
+            if (cmp(*p, *subBeginP) || cmp(*subBeginP, *p))
                 break;
 
-        if (p == end)
-            return {};
-
-        if (*p < *subBeginP)
+        if (p != end && cmp(*p, *subBeginP))
         {
             // Это убывающий подмассив, идем пока массив убывает
             for (; p != end; p++)
             {
                 auto bef = p;
                 bef--;
-                if (*bef < *p)
+                if (cmp(*bef, *p))
                     break;
             }
             std::reverse(subBeginP, p);
@@ -185,7 +202,7 @@ Stack<Pair<BidirectionalIterator, size_t>> splitAndSort(const BidirectionalItera
             {
                 auto bef = p;
                 bef--;
-                if (*bef > *p)
+                if (cmp(*p, *bef))
                     break;
             }
         }
@@ -213,7 +230,7 @@ Stack<Pair<BidirectionalIterator, size_t>> splitAndSort(const BidirectionalItera
             подмассива невелик и часть его уже упорядочена — сортировка работает 
             быстро и эффективно.
         */
-        InsertionSort(subBeginP, subEndP);
+        InsertionSort(subBeginP, subEndP, cmp);
 
         /*
             Указатель текущего элемента ставится на следующий за подмассивом элемент.
@@ -231,15 +248,16 @@ Stack<Pair<BidirectionalIterator, size_t>> splitAndSort(const BidirectionalItera
     return subs;
 }
 
-template < typename BidirectionalIterator >
+template < typename BidirectionalIterator, typename Compare >
 Pair<BidirectionalIterator, size_t> mergeWithoutGallop(Pair<BidirectionalIterator, size_t> left, 
-    Pair<BidirectionalIterator, size_t> right)
+    Pair<BidirectionalIterator, size_t> right, Compare cmp)
 {
-    auto _val = *left.first; // I do not know how to do this other way
-    DynArr<decltype(_val)> temp(left.second);
+    typedef typename std::iterator_traits<BidirectionalIterator>::value_type value_type;
+    MergeBuffer<value_type> temp;
+    temp.reserve(left.second);
     // move values from left subarray to temp array
-    for (auto i = left.first, j = temp.begin(); j != temp.end(); i++, j++)
-        *j = std::move(*i);
+    for (auto i = left.first; temp.size() != left.second; i++)
+        temp.push_back(std::move(*i));
 
     auto tempIt = temp.begin();
     auto rightIt = right.first;
@@ -266,32 +284,34 @@ Pair<BidirectionalIterator, size_t> mergeWithoutGallop(Pair<BidirectionalIterato
         else
         {
             // has not reached end of any array
-            *resultIt = std::min(*tempIt, *rightIt);
-            resultIt++;
-            if (*tempIt <= *rightIt)
+            if (!cmp(*rightIt, *tempIt))
             {
+                *resultIt = std::move(*tempIt);
                 tempIt++;
                 tempIndex++;
             }
             else
             {
+                *resultIt = std::move(*rightIt);
                 rightIt++;
                 rightIndex++;
             }
+            resultIt++;
         }
     }
     return {left.first, left.second + right.second};
 }
 
-template < typename RandomAccessIterator >
+template < typename RandomAccessIterator, typename Compare >
 Pair<RandomAccessIterator, size_t> merge(Pair<RandomAccessIterator, size_t> left, 
-    Pair<RandomAccessIterator, size_t> right)
+    Pair<RandomAccessIterator, size_t> right, Compare cmp)
 {
-    auto _val = *left.first; // I do not know how to do this other way
-    DynArr<decltype(_val)> temp(left.second);
+    typedef typename std::iterator_traits<RandomAccessIterator>::value_type value_type;
+    MergeBuffer<value_type> temp;
+    temp.reserve(left.second);
     // move values from left subarray to temp array
-    for (auto i = left.first, j = temp.begin(); j != temp.end(); i++, j++)
-        *j = std::move(*i);
+    for (auto i = left.first; temp.size() != left.second; i++)
+        temp.push_back(std::move(*i));
 
     auto tempIt = temp.begin();
     auto rightIt = right.first;
@@ -308,7 +328,7 @@ Pair<RandomAccessIterator, size_t> merge(Pair<RandomAccessIterator, size_t> left
         {
             // reached end of right array
             for (; tempIt != temp.end(); resultIt++, tempIt++)
-                *resultIt = *tempIt;
+                *resultIt = std::move(*tempIt);
 
             break;
         }
@@ -320,33 +340,37 @@ Pair<RandomAccessIterator, size_t> merge(Pair<RandomAccessIterator, size_t> left
                 // start galloping mode
                 if (fromSub == 1)
                 {
+                    // elements of temp which are not greater than *rightIt
                     auto newIt = tempIt;
                     for(;;)
                     {
                         std::ptrdiff_t diff = temp.end() - newIt;
                         auto it = newIt + diff / 2;
-                        if (it != newIt && *it < *rightIt)
+                        if (it != newIt && !cmp(*rightIt, *it))
                             newIt = it;
                         else
                             break;
                     }
-                    for (; newIt - tempIt >= 0; resultIt++, tempIt++)
-                        *resultIt = *tempIt;
+                    if (!cmp(*rightIt, *newIt))
+                        for (; newIt - tempIt >= 0; resultIt++, tempIt++)
+                            *resultIt = std::move(*tempIt);
                 }
                 else if (fromSub == 2)
                 {
+                    // elements of right which are less than *tempIt
                     auto newIt = rightIt;
                     for(;;)
                     {
                         std::ptrdiff_t diff = right.first + right.second - newIt;
                         auto it = newIt + diff / 2;
-                        if (it != newIt && *it < *tempIt)
+                        if (it != newIt && cmp(*it, *tempIt))
                             newIt = it;
                         else
                             break;
                     }
-                    for (; newIt - rightIt >= 0; resultIt++, rightIt++)
-                        *resultIt = *rightIt;
+                    if (cmp(*newIt, *tempIt))
+                        for (; newIt - rightIt >= 0; resultIt++, rightIt++)
+                            *resultIt = std::move(*rightIt);
                 }
                 else
                     throw std::logic_error("error in galloping mode");
@@ -356,10 +380,10 @@ Pair<RandomAccessIterator, size_t> merge(Pair<RandomAccessIterator, size_t> left
             }
             else
             {
-                *resultIt = std::min(*tempIt, *rightIt);
-                resultIt++;
-                if (*tempIt <= *rightIt)
+                if (!cmp(*rightIt, *tempIt))
                 {
+                    *resultIt = std::move(*tempIt);
+                    resultIt++;
                     tempIt++;
                     if (fromSub == 1)
                         numElemsFromThisSub++;
@@ -371,6 +395,8 @@ Pair<RandomAccessIterator, size_t> merge(Pair<RandomAccessIterator, size_t> left
                 }
                 else
                 {
+                    *resultIt = std::move(*rightIt);
+                    resultIt++;
                     rightIt++;
                     if (fromSub == 2)
                         numElemsFromThisSub++;
@@ -386,8 +412,9 @@ Pair<RandomAccessIterator, size_t> merge(Pair<RandomAccessIterator, size_t> left
     return {left.first, left.second + right.second};
 }
 
-template < typename BidirectionalIterator >
-void mergeAll(Stack<Pair<BidirectionalIterator, size_t>> subs, BidirectionalIterator begin, BidirectionalIterator end)
+template < typename BidirectionalIterator, typename Compare >
+void mergeAll(Stack<Pair<BidirectionalIterator, size_t>> subs, BidirectionalIterator begin, 
+    BidirectionalIterator end, Compare cmp)
 {
     if (subs.size() == 0)
         return;
@@ -412,20 +439,21 @@ void mergeAll(Stack<Pair<BidirectionalIterator, size_t>> subs, BidirectionalIter
             // stack size >= 2 && y <= x -> merge(x, y)
             if (second.second <= third.second)
             {
-                stack.push(merge(third, second));
+                stack.push(merge(third, second, cmp));
             }
             // stack size >= 3 && z <= x + y -> merge(y, min(x, z))
             else if (!stack.empty() && stack.top().second <= third.second + second.second)
             {
                 if (third.second <= stack.top().second)
-                    stack.push(merge(third, second));
+                    stack.push(merge(third, second, cmp));
                 else
                 {
-                    stack.push(third);
+                    // merge(y, z), x stays on the top
                     auto first = stack.top();
                     stack.pop();
-                    stack.push(merge(second, first));
-                }   
+                    stack.push(merge(second, first, cmp));
+                    stack.push(third);
+                }
             }
             else
             {
@@ -445,6 +473,8 @@ void mergeAll(Stack<Pair<BidirectionalIterator, size_t>> subs, BidirectionalIter
         stack.pop();
         auto y = stack.top();
         stack.pop();
-        stack.push(merge(x, y));
+        stack.push(merge(x, y, cmp));
     }
 }
+
+#endif // TIM_SORT_HPP_INCLUDED